@@ -0,0 +1,92 @@
+#include "frame_scheduler.h"
+#include <algorithm>
+#include <thread>
+
+FrameScheduler::FrameScheduler(double step, int maxSteps)
+    : fixedStep(step), maxStepsPerFrame(std::max(1, maxSteps)), accumulator(0.0), simTime(0.0),
+      droppedSteps(0), started(false), framePeriod(Clock::duration::zero()),
+      oversleep(Clock::duration::zero()), wakeErrors(1024), inputLatched(false), swapWaits(false),
+      latencies(1024) {
+    // Frames between reports are unbounded (--no-vsync), memory is not
+    wakeErrors.setCapacity(1024);
+    latencies.setCapacity(1024);
+}
+
+void FrameScheduler::setFrameLimit(double framesPerSecond) {
+    if (framesPerSecond <= 0.0) {
+        framePeriod = Clock::duration::zero();
+        return;
+    }
+    framePeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond));
+    nextDeadline = Clock::time_point();
+}
+
+void FrameScheduler::waitForFrame() {
+    if (framePeriod == Clock::duration::zero()) return;
+
+    // After a long frame, restart pacing from now instead of catching up
+    Clock::time_point now = Clock::now();
+    if (nextDeadline + framePeriod < now) {
+        nextDeadline = now;
+    }
+
+    Clock::time_point wake = nextDeadline - oversleep;
+    if (wake > now) {
+        std::this_thread::sleep_until(wake);
+        Clock::time_point woke = Clock::now();
+
+        // Smooth the lateness so one preempted sleep does not skew pacing
+        Clock::duration late = woke - wake;
+        oversleep += (late - oversleep) / 8;
+        wakeErrors.addSample(std::chrono::duration<double, std::milli>(woke - nextDeadline).count());
+    }
+    nextDeadline += framePeriod;
+}
+
+void FrameScheduler::beginFrame() {
+    Clock::time_point now = Clock::now();
+    if (!started) {
+        lastFrame = now;
+        started = true;
+    }
+    double elapsed = std::chrono::duration<double>(now - lastFrame).count();
+    lastFrame = now;
+
+    accumulator += elapsed;
+    double maxTime = fixedStep * maxStepsPerFrame;
+    if (accumulator > maxTime) {
+        droppedSteps += (long long)((accumulator - maxTime) / fixedStep);
+        accumulator = maxTime;
+    }
+}
+
+bool FrameScheduler::nextStep() {
+    if (accumulator < fixedStep) return false;
+    accumulator -= fixedStep;
+    simTime += fixedStep;
+    return true;
+}
+
+void FrameScheduler::latchInput() {
+    inputTime = Clock::now();
+    inputLatched = true;
+}
+
+void FrameScheduler::frameSwapped() {
+    if (!inputLatched) return;
+    latencies.addSample(std::chrono::duration<double, std::milli>(Clock::now() - inputTime).count());
+    inputLatched = false;
+}
+
+void FrameScheduler::report(std::ostream& out) {
+    latencies.report(swapWaits ? "Input-to-present latency" : "Input-to-swap latency", out);
+    if (wakeErrors.count() > 0) {
+        wakeErrors.report("Frame limiter wake error", out);
+    }
+    if (droppedSteps > 0) {
+        out << "Simulation steps dropped after hitches: " << droppedSteps << std::endl;
+    }
+    latencies.clear();
+    wakeErrors.clear();
+    droppedSteps = 0;
+}
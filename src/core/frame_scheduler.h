@@ -0,0 +1,84 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <chrono>
+#include <iostream>
+#include "frame_stats.h"
+
+// Decouples simulation from rendering.
+//
+// Simulation advances in fixed steps drawn from an accumulator of real
+// time; rendering interpolates between the last two states with alpha().
+// After a hitch at most maxStepsPerFrame steps are run and the rest of
+// the time is dropped, so a slow frame cannot snowball.
+//
+// The optional frame limiter paces frames against fixed deadlines and
+// sleeps instead of spinning. Sleeps return late by a roughly constant
+// amount, so that oversleep is measured and the next sleep ends earlier.
+//
+// Latency is measured from the moment input is latched for the view
+// matrix to frameSwapped(). When the swap returns before the frame is
+// shown (vsync, queued frames) that is input-to-swap; callers that wait
+// for the GPU after the swap call setSwapWaits(true) and get
+// input-to-present.
+class FrameScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FrameScheduler(double fixedStep = 1.0 / 120.0, int maxStepsPerFrame = 8);
+
+    // Target frame rate for waitForFrame(); 0 disables the limiter
+    void setFrameLimit(double framesPerSecond);
+
+    // Sleeps until the next frame slot when a limit is set
+    void waitForFrame();
+
+    // Adds the real time since the previous frame to the accumulator
+    void beginFrame();
+
+    // True while a fixed step is due; each call consumes one
+    bool nextStep();
+
+    double step() const { return fixedStep; }
+    double simulationTime() const { return simTime; }
+
+    // Progress from the previous state to the latest, in [0, 1)
+    double alpha() const { return accumulator / fixedStep; }
+
+    // Simulation time matching the interpolated state
+    double interpolatedTime() const { return simTime - fixedStep + accumulator; }
+
+    void latchInput();
+    void frameSwapped();
+
+    // True when frameSwapped() is called after waiting for the swap to finish
+    void setSwapWaits(bool waits) { swapWaits = waits; }
+
+    const FrameStats& latency() const { return latencies; }
+
+    // Prints latency and limiter statistics, then starts a new window.
+    // Each window keeps at most the latest 1024 samples per statistic.
+    void report(std::ostream& out = std::cout);
+
+private:
+    double fixedStep;
+    int maxStepsPerFrame;
+    double accumulator;
+    double simTime;
+    long long droppedSteps;
+
+    bool started;
+    Clock::time_point lastFrame;
+
+    Clock::duration framePeriod;
+    Clock::time_point nextDeadline;
+    Clock::duration oversleep;   // running estimate of how late sleeps return
+    FrameStats wakeErrors;       // wake time minus deadline, ms
+
+    bool inputLatched;
+    bool swapWaits;
+    Clock::time_point inputTime;
+    FrameStats latencies;
+};
+
+#endif // FRAME_SCHEDULER_H
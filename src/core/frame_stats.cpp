@@ -0,0 +1,78 @@
+#include "frame_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+
+FrameStats::FrameStats(size_t reserve) : capacity(0), next(0) {
+    samples.reserve(reserve);
+}
+
+void FrameStats::setCapacity(size_t maxSamples) {
+    capacity = maxSamples;
+    if (capacity > 0 && samples.size() > capacity) {
+        samples.erase(samples.begin(), samples.end() - capacity);
+    }
+    samples.reserve(capacity);
+    next = 0;
+}
+
+void FrameStats::addSample(double milliseconds) {
+    // Statistics ignore order, so the ring needs no head pointer for reads
+    if (capacity > 0 && samples.size() >= capacity) {
+        samples[next] = milliseconds;
+        next = (next + 1) % capacity;
+        return;
+    }
+    samples.push_back(milliseconds);
+}
+
+void FrameStats::clear() {
+    samples.clear();
+    next = 0;
+}
+
+double FrameStats::total() const {
+    return std::accumulate(samples.begin(), samples.end(), 0.0);
+}
+
+double FrameStats::average() const {
+    return samples.empty() ? 0.0 : total() / samples.size();
+}
+
+double FrameStats::minimum() const {
+    return samples.empty() ? 0.0 : *std::min_element(samples.begin(), samples.end());
+}
+
+double FrameStats::maximum() const {
+    return samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end());
+}
+
+double FrameStats::percentile(double p) const {
+    if (samples.empty()) return 0.0;
+
+    std::vector<double> sorted(samples);
+    size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+    rank = std::max<size_t>(1, std::min(rank, sorted.size()));
+    std::nth_element(sorted.begin(), sorted.begin() + (rank - 1), sorted.end());
+    return sorted[rank - 1];
+}
+
+void FrameStats::report(const std::string& label, std::ostream& out) const {
+    if (samples.empty()) {
+        out << label << ": no samples" << std::endl;
+        return;
+    }
+
+    std::ios oldState(nullptr);
+    oldState.copyfmt(out);
+
+    double avg = average();
+    out << std::fixed << std::setprecision(3)
+        << label << ": " << samples.size() << " samples, "
+        << "avg " << avg << " ms (" << (avg > 0.0 ? 1000.0 / avg : 0.0) << " /s), "
+        << "min " << minimum() << ", p50 " << percentile(50.0)
+        << ", p95 " << percentile(95.0) << ", p99 " << percentile(99.0)
+        << ", max " << maximum() << " ms" << std::endl;
+    out.copyfmt(oldState);
+}
@@ -0,0 +1,38 @@
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+// Collects per-frame timing samples (in milliseconds) and reports
+// average and percentile statistics.
+class FrameStats {
+public:
+    explicit FrameStats(size_t reserve = 0);
+
+    // Keeps at most maxSamples, overwriting the oldest once full, so
+    // long-running collectors use fixed memory. 0 (default) keeps all.
+    void setCapacity(size_t maxSamples);
+
+    void addSample(double milliseconds);
+    void clear();
+
+    size_t count() const { return samples.size(); }
+    double total() const;
+    double average() const;
+    double minimum() const;
+    double maximum() const;
+
+    // p in [0, 100], nearest-rank on a sorted copy
+    double percentile(double p) const;
+
+    void report(const std::string& label, std::ostream& out = std::cout) const;
+
+private:
+    std::vector<double> samples;
+    size_t capacity;
+    size_t next;    // slot overwritten next once at capacity
+};
+
+#endif // FRAME_STATS_H
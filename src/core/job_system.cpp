@@ -0,0 +1,168 @@
+#include "job_system.h"
+#include <algorithm>
+
+namespace {
+// Index of the worker running on this thread, -1 for external threads
+thread_local int currentWorker = -1;
+}
+
+JobSystem::JobSystem(unsigned int workerCount) {
+    if (workerCount == 0) {
+        unsigned int hardware = std::thread::hardware_concurrency();
+        workerCount = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    for (unsigned int i = 0; i < workerCount; i++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (unsigned int i = 0; i < workerCount; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    // Outstanding jobs are drained before the workers exit
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+JobHandle JobSystem::schedule(std::function<void()> task, const std::vector<JobHandle>& dependencies) {
+    JobHandle job = std::make_shared<Job>();
+    job->task = std::move(task);
+    outstandingJobs++;
+
+    // The extra count keeps the job from starting while dependencies are registered
+    job->pendingDependencies = (int)dependencies.size() + 1;
+    for (const JobHandle& dependency : dependencies) {
+        std::lock_guard<std::mutex> lock(dependency->dependentsMutex);
+        if (dependency->finished) {
+            job->pendingDependencies--;
+        } else {
+            dependency->dependents.push_back(job);
+        }
+    }
+
+    if (--job->pendingDependencies == 0) {
+        enqueue(job);
+    }
+    return job;
+}
+
+JobHandle JobSystem::parallelFor(int begin, int end, int grainSize, std::function<void(int, int)> body,
+                                 const std::vector<JobHandle>& dependencies) {
+    grainSize = std::max(1, grainSize);
+    auto shared = std::make_shared<std::function<void(int, int)>>(std::move(body));
+
+    std::vector<JobHandle> chunks;
+    for (int chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize) {
+        int chunkEnd = std::min(end, chunkBegin + grainSize);
+        chunks.push_back(schedule([shared, chunkBegin, chunkEnd]() { (*shared)(chunkBegin, chunkEnd); }, dependencies));
+    }
+    if (chunks.empty()) {
+        return schedule([]() {}, dependencies);
+    }
+    return schedule([]() {}, chunks);
+}
+
+void JobSystem::wait(const JobHandle& job) {
+    while (!job->finished) {
+        if (!runOne(currentWorker)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::workerLoop(unsigned int index) {
+    currentWorker = (int)index;
+
+    while (true) {
+        if (runOne((int)index)) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this]() {
+            return queuedJobs > 0 || (stopping && outstandingJobs == 0);
+        });
+        if (stopping && outstandingJobs == 0) break;
+    }
+}
+
+void JobSystem::enqueue(const JobHandle& job) {
+    // Jobs spawned by a worker stay on its own deque for locality
+    unsigned int index = currentWorker >= 0 ? (unsigned int)currentWorker
+                                            : nextQueue++ % (unsigned int)queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->jobs.push_back(job);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedJobs++;
+    }
+    wakeCondition.notify_one();
+}
+
+bool JobSystem::runOne(int preferredQueue) {
+    JobHandle job = popJob(preferredQueue);
+    if (!job) return false;
+    execute(job);
+    return true;
+}
+
+JobHandle JobSystem::popJob(int preferredQueue) {
+    // Own queue: newest first (LIFO)
+    if (preferredQueue >= 0) {
+        WorkQueue& own = *queues[preferredQueue];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            JobHandle job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            queuedJobs--;
+            return job;
+        }
+    }
+
+    // Steal: oldest first (FIFO) from the other queues
+    size_t count = queues.size();
+    size_t start = preferredQueue >= 0 ? (size_t)preferredQueue + 1 : 0;
+    for (size_t i = 0; i < count; i++) {
+        WorkQueue& victim = *queues[(start + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            JobHandle job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            queuedJobs--;
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::execute(const JobHandle& job) {
+    job->task();
+    job->task = nullptr;
+
+    std::vector<JobHandle> ready;
+    {
+        std::lock_guard<std::mutex> lock(job->dependentsMutex);
+        job->finished = true;
+        ready.swap(job->dependents);
+    }
+    for (const JobHandle& dependent : ready) {
+        if (--dependent->pendingDependencies == 0) {
+            enqueue(dependent);
+        }
+    }
+
+    // Wake sleepers so shutdown can observe the last completion
+    if (--outstandingJobs == 0) {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeCondition.notify_all();
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A unit of work. It becomes runnable once all of its dependencies finish.
+struct Job {
+    std::function<void()> task;
+    std::atomic<int> pendingDependencies{0};
+    std::atomic<bool> finished{false};
+
+    std::mutex dependentsMutex;
+    std::vector<std::shared_ptr<Job>> dependents;
+};
+
+using JobHandle = std::shared_ptr<Job>;
+
+// Fixed pool of worker threads, each owning a deque. Workers pop their own
+// newest job first and steal the oldest job from other workers when idle.
+class JobSystem {
+public:
+    // 0 selects hardware_concurrency() - 1 workers
+    explicit JobSystem(unsigned int workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    JobHandle schedule(std::function<void()> task, const std::vector<JobHandle>& dependencies = {});
+
+    // Splits [begin, end) into chunks of at most grainSize and returns a
+    // handle that completes when every chunk has run
+    JobHandle parallelFor(int begin, int end, int grainSize, std::function<void(int, int)> body,
+                          const std::vector<JobHandle>& dependencies = {});
+
+    // Blocks until the job finishes, running other jobs meanwhile
+    void wait(const JobHandle& job);
+
+    unsigned int workerCount() const { return (unsigned int)workers.size(); }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<JobHandle> jobs;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<int> queuedJobs{0};
+    std::atomic<int> outstandingJobs{0};
+    std::atomic<unsigned int> nextQueue{0};
+    bool stopping = false;
+
+    void workerLoop(unsigned int index);
+    void enqueue(const JobHandle& job);
+    bool runOne(int preferredQueue);
+    JobHandle popJob(int preferredQueue);
+    void execute(const JobHandle& job);
+};
+
+#endif // JOB_SYSTEM_H
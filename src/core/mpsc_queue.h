@@ -0,0 +1,50 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free multi-producer / single-consumer queue (Vyukov's
+// node-based design). push() may be called from any thread, pop() only
+// from the single consumer thread.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head(new Node()), tail(head.load()) {}
+
+    ~MpscQueue() {
+        T discarded;
+        while (pop(discarded)) {}
+        delete tail;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node();
+        node->value = std::move(value);
+        Node* previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    bool pop(T& out) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+        out = std::move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    std::atomic<Node*> head; // producers
+    Node* tail;              // consumer
+};
+
+#endif // MPSC_QUEUE_H
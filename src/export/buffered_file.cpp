@@ -0,0 +1,82 @@
+#include "buffered_file.h"
+#include <cstring>
+#include <iostream>
+
+BufferedFile::BufferedFile(size_t bufferSize)
+    : file(nullptr), buffer(bufferSize), used(0), written(0), error(false) {}
+
+BufferedFile::~BufferedFile() {
+    if (file) close();
+}
+
+bool BufferedFile::open(const std::string& path) {
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "ERROR: Failed to open output file: " << path << std::endl;
+        return false;
+    }
+    // The stdio buffer would only add a second copy
+    std::setvbuf(file, NULL, _IONBF, 0);
+    used = 0;
+    written = 0;
+    error = false;
+    return true;
+}
+
+bool BufferedFile::close() {
+    if (!file) return false;
+    flush();
+    if (std::fclose(file) != 0) error = true;
+    file = nullptr;
+    return !error;
+}
+
+void BufferedFile::write(const void* data, size_t length) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    written += length;
+
+    if (used + length > buffer.size()) {
+        flush();
+        // Large blocks bypass the buffer entirely
+        if (length >= buffer.size()) {
+            if (std::fwrite(bytes, 1, length, file) != length) error = true;
+            return;
+        }
+    }
+    std::memcpy(&buffer[used], bytes, length);
+    used += length;
+}
+
+void BufferedFile::writeU16(uint16_t v) {
+    unsigned char b[2] = { (unsigned char)v, (unsigned char)(v >> 8) };
+    write(b, 2);
+}
+
+void BufferedFile::writeU32(uint32_t v) {
+    unsigned char b[4] = { (unsigned char)v, (unsigned char)(v >> 8), (unsigned char)(v >> 16), (unsigned char)(v >> 24) };
+    write(b, 4);
+}
+
+void BufferedFile::writeU64(uint64_t v) {
+    writeU32((uint32_t)v);
+    writeU32((uint32_t)(v >> 32));
+}
+
+void BufferedFile::writeF32(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, 4);
+    writeU32(bits);
+}
+
+void BufferedFile::pad(size_t alignment, unsigned char value) {
+    while (written % alignment != 0) {
+        write(&value, 1);
+    }
+}
+
+void BufferedFile::flush() {
+    if (used > 0 && file) {
+        if (std::fwrite(buffer.data(), 1, used, file) != used) error = true;
+    }
+    used = 0;
+}
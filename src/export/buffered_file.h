@@ -0,0 +1,39 @@
+#ifndef BUFFERED_FILE_H
+#define BUFFERED_FILE_H
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Sequential binary writer that batches small writes into a large buffer
+// and hands big blocks straight to the OS. Values are little-endian.
+class BufferedFile {
+public:
+    explicit BufferedFile(size_t bufferSize = 4 << 20);
+    ~BufferedFile();
+
+    bool open(const std::string& path);
+    bool close();
+
+    void write(const void* data, size_t length);
+    void writeU16(uint16_t v);
+    void writeU32(uint32_t v);
+    void writeU64(uint64_t v);
+    void writeF32(float v);
+    void pad(size_t alignment, unsigned char value = 0);
+
+    uint64_t position() const { return written; }
+    bool failed() const { return error; }
+
+private:
+    std::FILE* file;
+    std::vector<unsigned char> buffer;
+    size_t used;
+    uint64_t written;
+    bool error;
+
+    void flush();
+};
+
+#endif // BUFFERED_FILE_H
@@ -0,0 +1,404 @@
+#include "terrain_exporter.h"
+#include "buffered_file.h"
+#include "../graphics/png_writer.h"
+#include "../graphics/mesh_optimizer.h"
+#include "../terrain/terrain.h"
+#include "../terrain/heightfield_simplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+const char TILED_MAGIC[4] = { 'T', 'R', 'N', 'T' };
+const uint32_t TILED_VERSION = 1;
+const size_t TILED_HEADER_BYTES = 36;
+const size_t TILED_ENTRY_BYTES = 16;
+
+// Raw float/uint32 blocks are written as-is, which matches the
+// little-endian layout both formats require on x86 and ARM hosts
+static_assert(sizeof(float) == 4, "32-bit floats required");
+
+bool readBytes(std::FILE* file, void* data, size_t length) {
+    return std::fread(data, 1, length, file) == length;
+}
+
+// Tile offsets of large grids pass 2 GB, beyond long on LLP64 targets
+bool seekTo(std::FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+uint32_t decodeU32(const unsigned char* b) {
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+float decodeF32(const unsigned char* b) {
+    uint32_t bits = decodeU32(b);
+    float v;
+    std::memcpy(&v, &bits, 4);
+    return v;
+}
+
+// glTF binary header and JSON chunk for one indexed mesh with interleaved
+// position/normal vertices; the caller writes the BIN chunk payload next
+bool beginGlb(BufferedFile& out, const std::string& path, uint64_t vertexCount, uint64_t indexCount,
+              float scale, float minHeight, float maxHeight) {
+    const uint64_t vertexBytes = vertexCount * 24;
+    const uint64_t indexBytes = indexCount * 4;
+
+    std::ostringstream json;
+    json.precision(9);
+    json << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"TerrainGenerator\"},"
+         << "\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+         << "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1},\"indices\":2,\"mode\":4}]}],"
+         << "\"accessors\":["
+         << "{\"bufferView\":0,\"byteOffset\":0,\"componentType\":5126,\"count\":" << vertexCount
+         << ",\"type\":\"VEC3\",\"min\":[" << -scale / 2 << "," << minHeight << "," << -scale / 2
+         << "],\"max\":[" << scale / 2 << "," << maxHeight << "," << scale / 2 << "]},"
+         << "{\"bufferView\":0,\"byteOffset\":12,\"componentType\":5126,\"count\":" << vertexCount << ",\"type\":\"VEC3\"},"
+         << "{\"bufferView\":1,\"componentType\":5125,\"count\":" << indexCount << ",\"type\":\"SCALAR\"}],"
+         << "\"bufferViews\":["
+         << "{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" << vertexBytes << ",\"byteStride\":24,\"target\":34962},"
+         << "{\"buffer\":0,\"byteOffset\":" << vertexBytes << ",\"byteLength\":" << indexBytes << ",\"target\":34963}],"
+         << "\"buffers\":[{\"byteLength\":" << vertexBytes + indexBytes << "}]}";
+    std::string jsonText = json.str();
+    jsonText.append((4 - jsonText.size() % 4) % 4, ' ');
+
+    if (!out.open(path)) return false;
+
+    const uint64_t binBytes = vertexBytes + indexBytes;
+    out.writeU32(0x46546C67); // "glTF"
+    out.writeU32(2);
+    out.writeU32((uint32_t)(12 + 8 + jsonText.size() + 8 + binBytes));
+    out.writeU32((uint32_t)jsonText.size());
+    out.writeU32(0x4E4F534A); // "JSON"
+    out.write(jsonText.data(), jsonText.size());
+    out.writeU32((uint32_t)binBytes);
+    out.writeU32(0x004E4942); // "BIN"
+    return true;
+}
+
+} // namespace
+
+TerrainExporter::TerrainExporter(int width, int height, float scale, float heightScale, RowSource source)
+    : width(width), height(height), scale(scale), heightScale(heightScale), source(std::move(source)) {}
+
+TerrainExporter TerrainExporter::fromTerrain(const Terrain& terrain) {
+    const Terrain* t = &terrain;
+    RowSource rows = [t](int z, float* heights) {
+        if (t->heightMap.size() == (size_t)t->width * t->height) {
+            std::copy_n(&t->heightMap[(size_t)z * t->width], t->width, heights);
+        } else {
+            t->sampleRow(z, heights);
+        }
+    };
+    return TerrainExporter(terrain.width, terrain.height, terrain.scale, terrain.heightScale, rows);
+}
+
+void TerrainExporter::heightRange(float& minHeight, float& maxHeight) const {
+    std::vector<float> row(width);
+    minHeight = INFINITY;
+    maxHeight = -INFINITY;
+    for (int z = 0; z < height; z++) {
+        source(z, row.data());
+        auto range = std::minmax_element(row.begin(), row.end());
+        minHeight = std::min(minHeight, *range.first);
+        maxHeight = std::max(maxHeight, *range.second);
+    }
+}
+
+bool TerrainExporter::writeTiled(const std::string& path, int tileSize) const {
+    tileSize = std::max(1, std::min(tileSize, 65534));
+    const int tilesX = (width - 2) / tileSize + 1;
+    const int tilesZ = (height - 2) / tileSize + 1;
+
+    BufferedFile out;
+    if (!out.open(path)) return false;
+
+    out.write(TILED_MAGIC, 4);
+    out.writeU32(TILED_VERSION);
+    out.writeU32((uint32_t)width);
+    out.writeU32((uint32_t)height);
+    out.writeU32((uint32_t)tileSize);
+    out.writeU32((uint32_t)tilesX);
+    out.writeU32((uint32_t)tilesZ);
+    out.writeF32(scale);
+    out.writeF32(heightScale);
+
+    // Tiles share their edge samples, so sizes (and offsets) are known up front
+    auto samplesAlong = [tileSize](int tile, int gridSize) {
+        return std::min(tileSize, gridSize - 1 - tile * tileSize) + 1;
+    };
+    uint64_t offset = TILED_HEADER_BYTES + (uint64_t)tilesX * tilesZ * TILED_ENTRY_BYTES;
+    for (int tz = 0; tz < tilesZ; tz++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            int sx = samplesAlong(tx, width);
+            int sz = samplesAlong(tz, height);
+            uint32_t bytes = 8 + (uint32_t)sx * sz * 2;
+            out.writeU64(offset);
+            out.writeU32(bytes);
+            out.writeU16((uint16_t)sx);
+            out.writeU16((uint16_t)sz);
+            offset += bytes;
+        }
+    }
+
+    // One band of tile rows in memory; its last row starts the next band
+    std::vector<float> band((size_t)(tileSize + 1) * width);
+    std::vector<float> tile;
+    for (int tz = 0; tz < tilesZ; tz++) {
+        int sz = samplesAlong(tz, height);
+        int firstRow = 0;
+        if (tz > 0) {
+            std::copy_n(&band[(size_t)tileSize * width], width, band.begin());
+            firstRow = 1;
+        }
+        for (int r = firstRow; r < sz; r++) {
+            source(tz * tileSize + r, &band[(size_t)r * width]);
+        }
+
+        for (int tx = 0; tx < tilesX; tx++) {
+            int sx = samplesAlong(tx, width);
+            tile.resize((size_t)sx * sz);
+            for (int r = 0; r < sz; r++) {
+                std::copy_n(&band[(size_t)r * width + (size_t)tx * tileSize], sx, &tile[(size_t)r * sx]);
+            }
+
+            auto range = std::minmax_element(tile.begin(), tile.end());
+            float minHeight = *range.first;
+            float maxHeight = *range.second;
+            float quantize = maxHeight > minHeight ? 65535.0f / (maxHeight - minHeight) : 0.0f;
+
+            out.writeF32(minHeight);
+            out.writeF32(maxHeight);
+            for (float h : tile) {
+                out.writeU16((uint16_t)std::lround((h - minHeight) * quantize));
+            }
+        }
+    }
+
+    bool ok = out.close();
+    if (ok) {
+        std::cout << "Exported " << tilesX * tilesZ << " tiles to " << path << " (" << offset << " bytes)" << std::endl;
+    }
+    return ok;
+}
+
+bool TerrainExporter::readTile(const std::string& path, int tileX, int tileZ, Tile& tile) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "ERROR: Failed to open tiled terrain: " << path << std::endl;
+        return false;
+    }
+
+    unsigned char header[TILED_HEADER_BYTES];
+    bool ok = readBytes(file, header, sizeof(header)) && std::memcmp(header, TILED_MAGIC, 4) == 0 &&
+              decodeU32(header + 4) == TILED_VERSION;
+    int tilesX = ok ? (int)decodeU32(header + 20) : 0;
+    int tilesZ = ok ? (int)decodeU32(header + 24) : 0;
+    ok = ok && tileX >= 0 && tileZ >= 0 && tileX < tilesX && tileZ < tilesZ;
+
+    unsigned char entry[TILED_ENTRY_BYTES];
+    if (ok) {
+        uint64_t entryOffset = TILED_HEADER_BYTES + ((uint64_t)tileZ * tilesX + tileX) * TILED_ENTRY_BYTES;
+        ok = seekTo(file, entryOffset) && readBytes(file, entry, sizeof(entry));
+    }
+
+    if (ok) {
+        uint64_t offset = (uint64_t)decodeU32(entry) | ((uint64_t)decodeU32(entry + 4) << 32);
+        tile.samplesX = entry[12] | (entry[13] << 8);
+        tile.samplesZ = entry[14] | (entry[15] << 8);
+
+        std::vector<unsigned char> data((size_t)decodeU32(entry + 8));
+        ok = data.size() == 8 + (size_t)tile.samplesX * tile.samplesZ * 2 &&
+             seekTo(file, offset) && readBytes(file, data.data(), data.size());
+
+        if (ok) {
+            tile.minHeight = decodeF32(&data[0]);
+            tile.maxHeight = decodeF32(&data[4]);
+            float step = (tile.maxHeight - tile.minHeight) / 65535.0f;
+            tile.heights.resize((size_t)tile.samplesX * tile.samplesZ);
+            for (size_t i = 0; i < tile.heights.size(); i++) {
+                uint16_t q = (uint16_t)(data[8 + i * 2] | (data[9 + i * 2] << 8));
+                tile.heights[i] = tile.minHeight + q * step;
+            }
+        }
+    }
+
+    std::fclose(file);
+    if (!ok) {
+        std::cerr << "ERROR: Failed to read tile (" << tileX << ", " << tileZ << ") from " << path << std::endl;
+    }
+    return ok;
+}
+
+bool TerrainExporter::writeGlb(const std::string& path, float maxError) const {
+    if (maxError > 0.0f) {
+        return writeSimplifiedGlb(path, maxError);
+    }
+
+    const uint64_t vertexCount = (uint64_t)width * height;
+    const uint64_t indexCount = (uint64_t)(width - 1) * (height - 1) * 6;
+    const uint64_t vertexBytes = vertexCount * 24;
+    const uint64_t indexBytes = indexCount * 4;
+
+    if (vertexBytes + indexBytes > 0xFFFFFFF0ull) {
+        std::cerr << "ERROR: " << width << "x" << height << " grid exceeds the 4 GB glTF binary limit" << std::endl;
+        return false;
+    }
+
+    // POSITION accessors need exact bounds, which costs one extra pass
+    float minHeight, maxHeight;
+    heightRange(minHeight, maxHeight);
+
+    BufferedFile out;
+    if (!beginGlb(out, path, vertexCount, indexCount, scale, minHeight, maxHeight)) return false;
+
+    // Vertices: sliding window of three rows for central-difference normals
+    const float cellX = scale / (width - 1);
+    const float cellZ = scale / (height - 1);
+    std::vector<float> previous(width), current(width), next(width);
+    std::vector<float> vertexRow((size_t)width * 6);
+    source(0, current.data());
+    previous = current;
+
+    for (int z = 0; z < height; z++) {
+        if (z + 1 < height) {
+            source(z + 1, next.data());
+        } else {
+            next = current;
+        }
+
+        float zCoord = (float)z / (height - 1) * scale;
+        for (int x = 0; x < width; x++) {
+            float xCoord = (float)x / (width - 1) * scale;
+            float dx = current[std::max(0, x - 1)] - current[std::min(width - 1, x + 1)];
+            float dz = previous[x] - next[x];
+            Vector3 normal = Vector3(dx * cellZ, 2.0f * cellX * cellZ, dz * cellX).normalized();
+
+            float* v = &vertexRow[(size_t)x * 6];
+            v[0] = xCoord - scale / 2;
+            v[1] = current[x];
+            v[2] = zCoord - scale / 2;
+            v[3] = normal.x;
+            v[4] = normal.y;
+            v[5] = normal.z;
+        }
+        out.write(vertexRow.data(), vertexRow.size() * sizeof(float));
+
+        previous.swap(current);
+        current.swap(next);
+    }
+
+    // Indices are pure arithmetic; same strips as Terrain::generateIndices(), without tiles
+    const int stripCells = MeshOptimizer::DEFAULT_CACHE_SIZE / 2 - 1;
+    std::vector<uint32_t> indexRow;
+    indexRow.reserve((size_t)stripCells * 6);
+    for (int x0 = 0; x0 < width - 1; x0 += stripCells) {
+        int x1 = std::min(width - 1, x0 + stripCells);
+        for (int z = 0; z < height - 1; z++) {
+            indexRow.clear();
+            for (int x = x0; x < x1; x++) {
+                uint32_t a = (uint32_t)(z * width + x);
+                uint32_t b = a + 1;
+                uint32_t c = a + (uint32_t)width;
+                uint32_t d = c + 1;
+                indexRow.insert(indexRow.end(), { a, c, b, b, c, d });
+            }
+            out.write(indexRow.data(), indexRow.size() * sizeof(uint32_t));
+        }
+    }
+
+    bool ok = out.close();
+    if (ok) {
+        std::cout << "Exported glTF binary to " << path << " (" << out.position() << " bytes)" << std::endl;
+    }
+    return ok;
+}
+
+bool TerrainExporter::writeSimplifiedGlb(const std::string& path, float maxError) const {
+    // The simplifier needs the whole grid; heights are gathered once
+    std::vector<float> heights((size_t)width * height);
+    for (int z = 0; z < height; z++) {
+        source(z, &heights[(size_t)z * width]);
+    }
+
+    HeightfieldSimplifier::Result result = HeightfieldSimplifier(heights, width, height).extract(maxError);
+    if (result.reductionRatio() >= 1.0f) {
+        std::cout << "Simplified glTF saves no triangles at max error " << maxError
+                  << ", exporting the full grid" << std::endl;
+        return writeGlb(path);
+    }
+
+    // Normals come from the full grid, as in the streamed export
+    const float cellX = scale / (width - 1);
+    const float cellZ = scale / (height - 1);
+    auto heightAt = [&](int x, int z) {
+        x = std::max(0, std::min(width - 1, x));
+        z = std::max(0, std::min(height - 1, z));
+        return heights[(size_t)z * width + x];
+    };
+
+    std::vector<Vertex> vertices(result.heights.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        int x = (int)result.gridX[i];
+        int z = (int)result.gridZ[i];
+        float dx = heightAt(x - 1, z) - heightAt(x + 1, z);
+        float dz = heightAt(x, z - 1) - heightAt(x, z + 1);
+        vertices[i].position = Vector3((float)x * cellX - scale / 2, result.heights[i], (float)z * cellZ - scale / 2);
+        vertices[i].normal = Vector3(dx * cellZ, 2.0f * cellX * cellZ, dz * cellX).normalized();
+    }
+    std::vector<unsigned int>& indices = result.indices;
+    MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+    MeshOptimizer::optimizeVertexFetch(vertices, indices);
+
+    auto range = std::minmax_element(heights.begin(), heights.end());
+    float minHeight = *range.first;
+    float maxHeight = *range.second;
+
+    BufferedFile out;
+    if (!beginGlb(out, path, vertices.size(), indices.size(), scale, minHeight, maxHeight)) return false;
+
+    for (const Vertex& v : vertices) {
+        const float data[6] = { v.position.x, v.position.y, v.position.z, v.normal.x, v.normal.y, v.normal.z };
+        out.write(data, sizeof(data));
+    }
+    out.write(indices.data(), indices.size() * sizeof(uint32_t));
+
+    bool ok = out.close();
+    if (ok) {
+        std::cout << "Exported simplified glTF binary to " << path << ": " << result.triangleCount() << " of "
+                  << result.sourceTriangles << " triangles (" << result.reductionRatio() * 100.0f
+                  << "%) at max error " << maxError << " (" << out.position() << " bytes)" << std::endl;
+    }
+    return ok;
+}
+
+bool TerrainExporter::writeHeightmapPng(const std::string& path) const {
+    PngWriter png;
+    if (!png.open(path, width, height, 16, 1)) return false;
+
+    std::vector<float> row(width);
+    std::vector<uint16_t> pixels(width);
+    for (int z = 0; z < height; z++) {
+        source(z, row.data());
+        for (int x = 0; x < width; x++) {
+            float normalized = std::max(0.0f, std::min(1.0f, row[x] / heightScale));
+            pixels[x] = (uint16_t)std::lround(normalized * 65535.0f);
+        }
+        png.writeRow(pixels.data());
+    }
+
+    bool ok = png.close();
+    if (ok) {
+        std::cout << "Exported 16-bit heightmap to " << path << std::endl;
+    }
+    return ok;
+}
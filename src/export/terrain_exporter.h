@@ -0,0 +1,56 @@
+#ifndef TERRAIN_EXPORTER_H
+#define TERRAIN_EXPORTER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+class Terrain;
+
+// Streams a heightfield grid to disk one band of rows at a time, so the
+// full mesh never has to exist in memory. Rows come from a callback that
+// fills `width` heights for row z.
+//
+// Formats:
+//  - Tiled binary (.trn): header, tile offset table, then per-tile
+//    quantized 16-bit heights so readers can seek straight to one tile
+//  - glTF binary (.glb): positions, normals and uint32 indices; with a
+//    max error the grid is simplified first, which needs the whole
+//    height grid in memory
+//  - 16-bit grayscale PNG heightmap, 0..heightScale mapped to 0..65535
+class TerrainExporter {
+public:
+    using RowSource = std::function<void(int z, float* heights)>;
+
+    struct Tile {
+        int samplesX = 0, samplesZ = 0;
+        float minHeight = 0.0f, maxHeight = 0.0f;
+        std::vector<float> heights; // samplesX * samplesZ, row-major
+    };
+
+    TerrainExporter(int width, int height, float scale, float heightScale, RowSource source);
+
+    // Uses the terrain's height map when generated, otherwise samples noise
+    static TerrainExporter fromTerrain(const Terrain& terrain);
+
+    bool writeTiled(const std::string& path, int tileSize = 256) const;
+    // Streams the full grid. maxError > 0 instead writes an adaptive mesh
+    // within that vertical error, which does not stream: memory grows with
+    // the grid, so keep it for grids that fit comfortably.
+    bool writeGlb(const std::string& path, float maxError = 0.0f) const;
+    bool writeHeightmapPng(const std::string& path) const;
+
+    // Reads a single tile of a .trn file, seeking past everything else
+    static bool readTile(const std::string& path, int tileX, int tileZ, Tile& tile);
+
+private:
+    int width, height;
+    float scale, heightScale;
+    RowSource source;
+
+    void heightRange(float& minHeight, float& maxHeight) const;
+    bool writeSimplifiedGlb(const std::string& path, float maxError) const;
+};
+
+#endif // TERRAIN_EXPORTER_H
@@ -0,0 +1,80 @@
+#include "headless_context.h"
+#include <EGL/eglext.h>
+#include <iostream>
+
+HeadlessContext::HeadlessContext() : display(EGL_NO_DISPLAY), context(EGL_NO_CONTEXT) {}
+
+HeadlessContext::~HeadlessContext() {
+    destroy();
+}
+
+bool HeadlessContext::create(int majorVersion, int minorVersion) {
+    // Surfaceless platform first, default display as fallback
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        std::cerr << "Failed to initialize EGL display" << std::endl;
+        display = EGL_NO_DISPLAY;
+        return false;
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL does not support desktop OpenGL" << std::endl;
+        destroy();
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config = NULL;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) || numConfigs == 0) {
+        // Surfaceless displays may expose no configs at all
+        config = (EGLConfig)0; // EGL_NO_CONFIG_KHR
+    }
+
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, majorVersion,
+        EGL_CONTEXT_MINOR_VERSION, minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "Failed to create EGL context (error 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        destroy();
+        return false;
+    }
+
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::cerr << "Failed to make surfaceless EGL context current" << std::endl;
+        destroy();
+        return false;
+    }
+
+    std::cout << "EGL " << major << "." << minor << " (" << eglQueryString(display, EGL_VENDOR) << ")" << std::endl;
+    return true;
+}
+
+void HeadlessContext::destroy() {
+    if (display == EGL_NO_DISPLAY) return;
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+    eglTerminate(display);
+    context = EGL_NO_CONTEXT;
+    display = EGL_NO_DISPLAY;
+}
@@ -0,0 +1,22 @@
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <EGL/egl.h>
+
+// Windowless OpenGL core context created through EGL. Prefers the Mesa
+// surfaceless platform so it also works on GPU-less build servers with
+// llvmpipe (LIBGL_ALWAYS_SOFTWARE=1). Rendering must go to an FBO.
+class HeadlessContext {
+public:
+    HeadlessContext();
+    ~HeadlessContext();
+
+    bool create(int majorVersion = 3, int minorVersion = 3);
+    void destroy();
+
+private:
+    EGLDisplay display;
+    EGLContext context;
+};
+
+#endif // HEADLESS_CONTEXT_H
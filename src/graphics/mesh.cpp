@@ -1,48 +1,148 @@
 #include "mesh.h"
+#include <algorithm>
+#include <cstring>
 
-Mesh::Mesh() : VAO(0), VBO(0), EBO(0), setupDone(false) {}
+Mesh::Mesh()
+    : VAO(0), VBO(0), EBO(0), occlusionBuffer(0), includeColor(true), setupDone(false), uploading(false),
+      uploadedVertexBytes(0), uploadedOcclusionBytes(0), uploadedIndexBytes(0) {}
 
 Mesh::~Mesh() {
     cleanup();
 }
 
 void Mesh::setupMesh() {
+    beginUpload();
+    uploadChunk(uploadSize());
+}
+
+void Mesh::beginUpload() {
     if (vertices.empty() || indices.empty()) return;
 
+    cleanup();
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
 
     glBindVertexArray(VAO);
 
+    // Storage only; data arrives through uploadChunk()
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+    GLsizei stride = (GLsizei)vertexStride();
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * stride, NULL, GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), NULL, GL_STATIC_DRAW);
 
     // Position attribute
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
 
     // Normal attribute
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, normal));
 
     // Color attribute
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+    if (includeColor) {
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(Vertex, color));
+    }
+
+    // Occlusion attribute, normalized from its own byte buffer
+    if (occlusionBytes() > 0) {
+        glGenBuffers(1, &occlusionBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, occlusionBuffer);
+        glBufferData(GL_ARRAY_BUFFER, occlusionBytes(), NULL, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 1, GL_UNSIGNED_BYTE, GL_TRUE, 1, (void*)0);
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    uploadedVertexBytes = 0;
+    uploadedOcclusionBytes = 0;
+    uploadedIndexBytes = 0;
+    uploading = true;
+}
 
-    setupDone = true;
+size_t Mesh::uploadSize() const {
+    return vertices.size() * vertexStride() + occlusionBytes() + indices.size() * sizeof(unsigned int);
+}
+
+size_t Mesh::uploadChunk(size_t maxBytes) {
+    if (!uploading) return 0;
+
+    size_t copied = 0;
+    size_t stride = vertexStride();
+    size_t vertexBytes = vertices.size() * stride;
+    size_t occlusionSize = occlusionBuffer != 0 ? occlusion.size() : 0;
+    size_t indexBytes = indices.size() * sizeof(unsigned int);
+
+    if (uploadedVertexBytes < vertexBytes && copied < maxBytes) {
+        size_t count = std::min(vertexBytes - uploadedVertexBytes, maxBytes - copied);
+        const char* source = reinterpret_cast<const char*>(vertices.data()) + uploadedVertexBytes;
+
+        if (!includeColor) {
+            // Pack whole vertices without their color
+            size_t first = uploadedVertexBytes / stride;
+            size_t vertexCount = std::min(std::max<size_t>(1, count / stride), vertices.size() - first);
+            count = vertexCount * stride;
+            staging.resize(count);
+            for (size_t i = 0; i < vertexCount; i++) {
+                std::memcpy(&staging[i * stride], &vertices[first + i], stride);
+            }
+            source = staging.data();
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferSubData(GL_ARRAY_BUFFER, uploadedVertexBytes, count, source);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        uploadedVertexBytes += count;
+        copied += count;
+    }
+
+    if (uploadedOcclusionBytes < occlusionSize && copied < maxBytes) {
+        size_t count = std::min(occlusionSize - uploadedOcclusionBytes, maxBytes - copied);
+        glBindBuffer(GL_ARRAY_BUFFER, occlusionBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, uploadedOcclusionBytes, count, occlusion.data() + uploadedOcclusionBytes);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        uploadedOcclusionBytes += count;
+        copied += count;
+    }
+
+    if (uploadedIndexBytes < indexBytes && copied < maxBytes) {
+        // The element buffer binding is VAO state, so bind through the copy target
+        size_t count = std::min(indexBytes - uploadedIndexBytes, maxBytes - copied);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, uploadedIndexBytes, count,
+                        reinterpret_cast<const char*>(indices.data()) + uploadedIndexBytes);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        uploadedIndexBytes += count;
+        copied += count;
+    }
+
+    if (uploadedVertexBytes == vertexBytes && uploadedOcclusionBytes == occlusionSize &&
+        uploadedIndexBytes == indexBytes) {
+        uploading = false;
+        setupDone = true;
+        staging.clear();
+        staging.shrink_to_fit();
+    }
+    return copied;
 }
 
 void Mesh::draw() const {
-    if (!setupDone) return;
+    drawRange(0, indices.size());
+}
+
+void Mesh::drawRange(size_t firstIndex, size_t indexCount) const {
+    if (!setupDone || indexCount == 0) return;
     glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    // Generic attribute value stands in for a missing occlusion stream
+    if (occlusionBuffer == 0) glVertexAttrib1f(3, 1.0f);
+    glDrawElements(GL_TRIANGLES, (GLsizei)indexCount, GL_UNSIGNED_INT,
+                   (void*)(firstIndex * sizeof(unsigned int)));
     glBindVertexArray(0);
 }
 
@@ -50,4 +150,9 @@ void Mesh::cleanup() {
     if (VAO != 0) glDeleteVertexArrays(1, &VAO);
     if (VBO != 0) glDeleteBuffers(1, &VBO);
     if (EBO != 0) glDeleteBuffers(1, &EBO);
+    if (occlusionBuffer != 0) glDeleteBuffers(1, &occlusionBuffer);
+    VAO = VBO = EBO = 0;
+    occlusionBuffer = 0;
+    setupDone = false;
+    uploading = false;
 }
@@ -1 +1,59 @@
-#ifndef MESH_H\n#define MESH_H\n\nstruct Vertex {\n    float x;\n    float y;\n    float z;\n};\n\nstruct Mesh {\n    struct Vertex* vertices;\n    int vertexCount;\n};\n\n#endif // MESH_H
\ No newline at end of file
+#ifndef MESH_H
+#define MESH_H
+
+#include <GL/glew.h>
+#include <vector>
+#include <cstddef>
+#include "../math/math.h"
+
+struct Vertex {
+    Vector3 position;
+    Vector3 normal;
+    Vector3 color;
+};
+
+class Mesh {
+public:
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    GLuint VAO, VBO, EBO;
+
+    // Optional ambient occlusion, one byte per vertex (255 = unoccluded),
+    // uploaded as a separate stream. Without it the shader sees 1.0.
+    std::vector<unsigned char> occlusion;
+    GLuint occlusionBuffer;
+
+    // When false the GPU buffer holds only position and normal, and the
+    // shader derives color from height
+    bool includeColor;
+
+    Mesh();
+    ~Mesh();
+
+    // Creates the GL buffers and uploads everything at once
+    void setupMesh();
+
+    // Incremental upload: beginUpload() allocates the buffers, then each
+    // uploadChunk() call copies at most maxBytes. Returns the bytes copied.
+    void beginUpload();
+    size_t uploadChunk(size_t maxBytes);
+    bool isUploading() const { return uploading; }
+    bool isReady() const { return setupDone; }
+    size_t uploadSize() const;
+    size_t vertexStride() const { return includeColor ? sizeof(Vertex) : offsetof(Vertex, color); }
+    size_t occlusionBytes() const { return occlusion.size() == vertices.size() ? occlusion.size() : 0; }
+
+    void draw() const;
+    void drawRange(size_t firstIndex, size_t indexCount) const;
+    void cleanup();
+
+private:
+    bool setupDone;
+    bool uploading;
+    size_t uploadedVertexBytes;
+    size_t uploadedOcclusionBytes;
+    size_t uploadedIndexBytes;
+    std::vector<char> staging;
+};
+
+#endif // MESH_H
@@ -0,0 +1,131 @@
+#include "mesh_optimizer.h"
+
+namespace MeshOptimizer {
+
+float computeACMR(const std::vector<unsigned int>& indices, size_t vertexCount, int cacheSize) {
+    if (indices.size() < 3) return 0.0f;
+
+    // A FIFO only inserts on misses, so a vertex is still cached while
+    // fewer than cacheSize misses have happened since its own
+    const unsigned int notCached = ~0u;
+    std::vector<unsigned int> insertedAt(vertexCount, notCached);
+    unsigned int misses = 0;
+
+    for (unsigned int v : indices) {
+        if (insertedAt[v] == notCached || misses - insertedAt[v] >= (unsigned int)cacheSize) {
+            insertedAt[v] = misses;
+            misses++;
+        }
+    }
+    return (float)misses / (float)(indices.size() / 3);
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount, int cacheSize) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return;
+
+    // Vertex -> triangle adjacency
+    std::vector<unsigned int> liveTriangles(vertexCount, 0);
+    for (unsigned int v : indices) liveTriangles[v]++;
+
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + liveTriangles[v];
+
+    std::vector<unsigned int> adjacency(indices.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++) {
+            adjacency[fill[indices[t * 3 + k]]++] = (unsigned int)t;
+        }
+    }
+
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+
+    unsigned int timestamp = cacheSize + 1;
+    size_t cursor = 0;
+    long long fanning = 0;
+
+    while (fanning >= 0) {
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; a++) {
+            unsigned int t = adjacency[a];
+            if (emitted[t]) continue;
+
+            for (int k = 0; k < 3; k++) {
+                unsigned int v = indices[t * 3 + k];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (timestamp - cacheTime[v] > (unsigned int)cacheSize) {
+                    cacheTime[v] = timestamp++;
+                }
+            }
+            emitted[t] = 1;
+        }
+
+        // Next fanning vertex: the candidate that stays in cache longest
+        // while still having live triangles
+        long long best = -1;
+        long long bestPriority = -1;
+        for (unsigned int v : candidates) {
+            if (liveTriangles[v] == 0) continue;
+            long long priority = 0;
+            if (timestamp - cacheTime[v] + 2 * liveTriangles[v] <= (unsigned int)cacheSize) {
+                priority = timestamp - cacheTime[v];
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+
+        // Dead end: back off to recently used vertices, then scan forward
+        while (best < 0 && !deadEnd.empty()) {
+            unsigned int v = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[v] > 0) best = v;
+        }
+        while (best < 0 && cursor < vertexCount) {
+            if (liveTriangles[cursor] > 0) best = (long long)cursor;
+            cursor++;
+        }
+        fanning = best;
+    }
+
+    indices.swap(output);
+}
+
+std::vector<unsigned int> optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    const unsigned int unused = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), unused);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (unsigned int& index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = (unsigned int)reordered.size();
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    // Unreferenced vertices keep their relative order at the end
+    for (size_t v = 0; v < vertices.size(); v++) {
+        if (remap[v] == unused) {
+            remap[v] = (unsigned int)reordered.size();
+            reordered.push_back(vertices[v]);
+        }
+    }
+
+    vertices.swap(reordered);
+    return remap;
+}
+
+} // namespace MeshOptimizer
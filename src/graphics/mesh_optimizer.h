@@ -0,0 +1,30 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <vector>
+#include <cstddef>
+#include "mesh.h"
+
+// Post-transform vertex cache and vertex fetch optimization for indexed
+// triangle lists.
+namespace MeshOptimizer {
+
+// Typical post-transform cache size of desktop GPUs (FIFO entries)
+const int DEFAULT_CACHE_SIZE = 16;
+
+// Average cache miss ratio: vertex shader invocations per triangle for a
+// simulated FIFO cache. 0.5 is optimal for large grids, 3.0 is the worst case.
+float computeACMR(const std::vector<unsigned int>& indices, size_t vertexCount,
+                  int cacheSize = DEFAULT_CACHE_SIZE);
+
+// Reorders triangles for cache locality (Tipsify, Sander et al. 2007)
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount,
+                         int cacheSize = DEFAULT_CACHE_SIZE);
+
+// Reorders vertices into first-use order and rewrites the indices.
+// Returns the remap table (old index -> new index).
+std::vector<unsigned int> optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+} // namespace MeshOptimizer
+
+#endif // MESH_OPTIMIZER_H
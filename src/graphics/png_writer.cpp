@@ -0,0 +1,197 @@
+#include "png_writer.h"
+#include <iostream>
+#include <algorithm>
+
+namespace {
+
+uint32_t crcTable[256];
+bool crcTableReady = false;
+
+void buildCrcTable() {
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crcTable[n] = c;
+    }
+    crcTableReady = true;
+}
+
+uint32_t updateCrc(uint32_t crc, const unsigned char* data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+void putBE32(unsigned char* out, uint32_t v) {
+    out[0] = (unsigned char)(v >> 24);
+    out[1] = (unsigned char)(v >> 16);
+    out[2] = (unsigned char)(v >> 8);
+    out[3] = (unsigned char)v;
+}
+
+} // namespace
+
+PngWriter::PngWriter()
+    : file(nullptr), width(0), height(0), bitDepth(8), channels(4),
+      rowsWritten(0), rowBytes(0), adler(1) {}
+
+PngWriter::~PngWriter() {
+    if (file) close();
+}
+
+bool PngWriter::open(const std::string& path, int w, int h, int depth, int numChannels) {
+    if (!crcTableReady) buildCrcTable();
+
+    if ((depth != 8 && depth != 16) || numChannels < 1 || numChannels > 4 || numChannels == 2) {
+        std::cerr << "ERROR: Unsupported PNG format: " << depth << " bit, " << numChannels << " channels" << std::endl;
+        return false;
+    }
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "ERROR: Failed to open PNG file: " << path << std::endl;
+        return false;
+    }
+    fileBuffer.resize(1 << 20);
+    std::setvbuf(file, fileBuffer.data(), _IOFBF, fileBuffer.size());
+
+    width = w;
+    height = h;
+    bitDepth = depth;
+    channels = numChannels;
+    rowsWritten = 0;
+    rowBytes = (size_t)width * channels * (bitDepth / 8);
+    adler = 1;
+
+    static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::fwrite(signature, 1, sizeof(signature), file);
+
+    static const unsigned char colorTypes[5] = { 0, 0, 4, 2, 6 };
+    unsigned char ihdr[13];
+    putBE32(ihdr, (uint32_t)width);
+    putBE32(ihdr + 4, (uint32_t)height);
+    ihdr[8] = (unsigned char)bitDepth;
+    ihdr[9] = colorTypes[channels];
+    ihdr[10] = 0; // deflate
+    ihdr[11] = 0; // adaptive filtering
+    ihdr[12] = 0; // no interlace
+    writeChunk("IHDR", ihdr, sizeof(ihdr));
+
+    // zlib header: deflate, 32K window, no preset dictionary
+    chunk.clear();
+    chunk.push_back(0x78);
+    chunk.push_back(0x01);
+    return true;
+}
+
+bool PngWriter::writeRow(const void* row) {
+    if (!file || rowsWritten >= height) return false;
+
+    // Filter type 0 followed by big-endian samples
+    std::vector<unsigned char>& filtered = rowBuffer;
+    filtered.resize(rowBytes + 1);
+    filtered[0] = 0;
+    if (bitDepth == 16) {
+        const uint16_t* samples = static_cast<const uint16_t*>(row);
+        for (size_t i = 0; i < rowBytes / 2; i++) {
+            filtered[1 + i * 2] = (unsigned char)(samples[i] >> 8);
+            filtered[2 + i * 2] = (unsigned char)(samples[i] & 0xFF);
+        }
+    } else {
+        const unsigned char* bytes = static_cast<const unsigned char*>(row);
+        std::copy(bytes, bytes + rowBytes, filtered.begin() + 1);
+    }
+
+    updateAdler(filtered.data(), filtered.size());
+    appendStored(filtered.data(), filtered.size(), false);
+    writeChunk("IDAT", chunk.data(), chunk.size());
+    chunk.clear();
+
+    rowsWritten++;
+    return std::ferror(file) == 0;
+}
+
+bool PngWriter::close() {
+    if (!file) return false;
+
+    bool complete = rowsWritten == height;
+    if (!complete) {
+        std::cerr << "ERROR: PNG closed after " << rowsWritten << " of " << height << " rows" << std::endl;
+    }
+
+    // Empty final block terminates the deflate stream, then the Adler-32
+    appendStored(nullptr, 0, true);
+    unsigned char trailer[4];
+    putBE32(trailer, adler);
+    chunk.insert(chunk.end(), trailer, trailer + 4);
+    writeChunk("IDAT", chunk.data(), chunk.size());
+    chunk.clear();
+    writeChunk("IEND", nullptr, 0);
+
+    bool ok = std::ferror(file) == 0;
+    std::fclose(file);
+    file = nullptr;
+    return ok && complete;
+}
+
+bool PngWriter::writeRGBA8(const std::string& path, int width, int height,
+                           const unsigned char* pixels, bool flipY) {
+    PngWriter writer;
+    if (!writer.open(path, width, height, 8, 4)) return false;
+    for (int y = 0; y < height; y++) {
+        int srcRow = flipY ? height - 1 - y : y;
+        writer.writeRow(pixels + (size_t)srcRow * width * 4);
+    }
+    return writer.close();
+}
+
+void PngWriter::writeChunk(const char* type, const unsigned char* data, size_t length) {
+    unsigned char header[8];
+    putBE32(header, (uint32_t)length);
+    std::copy(type, type + 4, header + 4);
+    std::fwrite(header, 1, 8, file);
+    if (length > 0) std::fwrite(data, 1, length, file);
+
+    uint32_t crc = updateCrc(0xFFFFFFFFu, header + 4, 4);
+    if (length > 0) crc = updateCrc(crc, data, length);
+    unsigned char crcBytes[4];
+    putBE32(crcBytes, crc ^ 0xFFFFFFFFu);
+    std::fwrite(crcBytes, 1, 4, file);
+}
+
+void PngWriter::appendStored(const unsigned char* data, size_t length, bool final) {
+    // Stored blocks hold at most 65535 bytes each
+    do {
+        size_t blockLength = std::min<size_t>(length, 65535);
+        bool lastBlock = final && blockLength == length;
+        chunk.push_back(lastBlock ? 1 : 0);
+        chunk.push_back((unsigned char)(blockLength & 0xFF));
+        chunk.push_back((unsigned char)(blockLength >> 8));
+        chunk.push_back((unsigned char)(~blockLength & 0xFF));
+        chunk.push_back((unsigned char)((~blockLength >> 8) & 0xFF));
+        if (blockLength > 0) chunk.insert(chunk.end(), data, data + blockLength);
+        data += blockLength;
+        length -= blockLength;
+    } while (length > 0);
+}
+
+void PngWriter::updateAdler(const unsigned char* data, size_t length) {
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (length > 0) {
+        // 5552 is the largest run that cannot overflow 32 bits before the modulo
+        size_t run = std::min<size_t>(length, 5552);
+        for (size_t i = 0; i < run; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += run;
+        length -= run;
+    }
+    adler = (b << 16) | a;
+}
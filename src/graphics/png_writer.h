@@ -0,0 +1,44 @@
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal streaming PNG encoder. Rows are written one at a time as
+// uncompressed deflate blocks, so images of any size can be produced
+// without holding the whole image in memory.
+class PngWriter {
+public:
+    PngWriter();
+    ~PngWriter();
+
+    // bitDepth is 8 or 16, channels is 1 (gray), 3 (RGB) or 4 (RGBA)
+    bool open(const std::string& path, int width, int height, int bitDepth, int channels);
+
+    // 8-bit rows are raw bytes, 16-bit rows are host-order uint16_t samples
+    bool writeRow(const void* row);
+    bool close();
+
+    // Convenience for glReadPixels output (bottom-up RGBA8)
+    static bool writeRGBA8(const std::string& path, int width, int height,
+                           const unsigned char* pixels, bool flipY = true);
+
+private:
+    std::FILE* file;
+    int width, height;
+    int bitDepth, channels;
+    int rowsWritten;
+    size_t rowBytes;
+    uint32_t adler;
+    std::vector<unsigned char> rowBuffer;
+    std::vector<unsigned char> chunk;
+    std::vector<char> fileBuffer;
+
+    void writeChunk(const char* type, const unsigned char* data, size_t length);
+    void appendStored(const unsigned char* data, size_t length, bool final);
+    void updateAdler(const unsigned char* data, size_t length);
+};
+
+#endif // PNG_WRITER_H
@@ -0,0 +1,69 @@
+#include "render_target.h"
+#include <iostream>
+
+RenderTarget::RenderTarget() : FBO(0), colorBuffer(0), depthBuffer(0), width(0), height(0) {}
+
+RenderTarget::~RenderTarget() {
+    cleanup();
+}
+
+bool RenderTarget::create(int w, int h, GLenum depthFormat) {
+    cleanup();
+    width = w;
+    height = h;
+
+    glGenFramebuffers(1, &FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, depthFormat, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR: Framebuffer incomplete, status 0x" << std::hex << status << std::dec << std::endl;
+        cleanup();
+        return false;
+    }
+    return true;
+}
+
+void RenderTarget::bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glViewport(0, 0, width, height);
+}
+
+void RenderTarget::unbind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::readPixels(std::vector<unsigned char>& pixels) const {
+    pixels.resize((size_t)width * height * 4);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::blitToDefault(int targetWidth, int targetHeight) const {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, FBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, targetWidth, targetHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::cleanup() {
+    if (colorBuffer != 0) glDeleteRenderbuffers(1, &colorBuffer);
+    if (depthBuffer != 0) glDeleteRenderbuffers(1, &depthBuffer);
+    if (FBO != 0) glDeleteFramebuffers(1, &FBO);
+    colorBuffer = depthBuffer = FBO = 0;
+}
@@ -0,0 +1,32 @@
+#ifndef RENDER_TARGET_H
+#define RENDER_TARGET_H
+
+#include <GL/glew.h>
+#include <vector>
+
+// Offscreen framebuffer with an RGBA8 color renderbuffer and a depth
+// renderbuffer of configurable format.
+class RenderTarget {
+public:
+    GLuint FBO;
+    GLuint colorBuffer;
+    GLuint depthBuffer;
+    int width, height;
+
+    RenderTarget();
+    ~RenderTarget();
+
+    bool create(int width, int height, GLenum depthFormat = GL_DEPTH_COMPONENT24);
+    void bind() const;
+    void unbind() const;
+
+    // Reads the color attachment as bottom-up RGBA8
+    void readPixels(std::vector<unsigned char>& pixels) const;
+
+    // Copies the color attachment to the default framebuffer
+    void blitToDefault(int targetWidth, int targetHeight) const;
+
+    void cleanup();
+};
+
+#endif // RENDER_TARGET_H
@@ -69,10 +69,28 @@ void Shader::setVec3(const std::string& name, float x, float y, float z) const {
     glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
 }
 
+void Shader::setVec3(const std::string& name, const Vector3& value) const {
+    glUniform3f(glGetUniformLocation(ID, name.c_str()), value.x, value.y, value.z);
+}
+
+void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const {
+    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+}
+
 void Shader::setMat4(const std::string& name, float* mat) const {
     glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, mat);
 }
 
+void Shader::setMat4(const std::string& name, const Matrix4& mat) const {
+    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, mat.data());
+}
+
+void Shader::setMat4Array(const std::string& name, const Matrix4* mats, int count) const {
+    // Matrix4 is exactly 16 floats, so the array is contiguous
+    static_assert(sizeof(Matrix4) == 16 * sizeof(float), "Matrix4 must be tightly packed");
+    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), count, GL_FALSE, mats[0].data());
+}
+
 void Shader::checkCompileErrors(GLuint shader, const std::string& type) const {
     int success;
     char infoLog[1024];
@@ -3,6 +3,7 @@
 
 #include <GL/glew.h>
 #include <string>
+#include "../math/math.h"
 
 class Shader {
 public:
@@ -18,7 +19,11 @@ public:
     void setInt(const std::string& name, int value) const;
     void setFloat(const std::string& name, float value) const;
     void setVec3(const std::string& name, float x, float y, float z) const;
+    void setVec3(const std::string& name, const Vector3& value) const;
+    void setVec4(const std::string& name, float x, float y, float z, float w) const;
     void setMat4(const std::string& name, float* mat) const;
+    void setMat4(const std::string& name, const Matrix4& mat) const;
+    void setMat4Array(const std::string& name, const Matrix4* mats, int count) const;
 
 private:
     std::string readFile(const char* filePath) const;
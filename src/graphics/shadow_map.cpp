@@ -0,0 +1,323 @@
+#include "shadow_map.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+// Column-major point transform (w = 1)
+static Vector3 transformPoint(const Matrix4& mat, const Vector3& p) {
+    const float* m = mat.m;
+    return Vector3(m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12],
+                   m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13],
+                   m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]);
+}
+
+// Light-space bounds of a set of points
+struct LightBounds {
+    float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+    float maxX = -FLT_MAX, maxY = -FLT_MAX, maxZ = -FLT_MAX;
+
+    void add(const Vector3& p) {
+        minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+        minZ = std::min(minZ, p.z); maxZ = std::max(maxZ, p.z);
+    }
+    bool overlapsXY(const float lo[2], const float hi[2]) const {
+        return maxX >= lo[0] && minX <= hi[0] && maxY >= lo[1] && minY <= hi[1];
+    }
+};
+
+static LightBounds boxInLightSpace(const Matrix4& lightView, const BoundingBox& box) {
+    LightBounds bounds;
+    for (int c = 0; c < 8; c++) {
+        Vector3 corner((c & 1) ? box.max.x : box.min.x,
+                       (c & 2) ? box.max.y : box.min.y,
+                       (c & 4) ? box.max.z : box.min.z);
+        bounds.add(transformPoint(lightView, corner));
+    }
+    return bounds;
+}
+
+static Matrix4 makeLightView(const Vector3& lightDir) {
+    Vector3 up = std::fabs(lightDir.y) > 0.99f ? Vector3(0.0f, 0.0f, 1.0f) : Vector3(0.0f, 1.0f, 0.0f);
+    return Matrix4::lookAt(Vector3(0.0f, 0.0f, 0.0f), -lightDir, up);
+}
+
+CascadedShadowMap::CascadedShadowMap()
+    : depthTexture(0), FBO(0), timerQueries{ 0, 0 }, queryPending{ false, false },
+      frameIndex(0), clipControl(false), renderedCount(0), totalRendered(0), framesRendered(0),
+      lightDirection(0.0f, 1.0f, 0.0f), gpuTimes(1024) {
+}
+
+CascadedShadowMap::~CascadedShadowMap() {
+    cleanup();
+}
+
+bool CascadedShadowMap::create(const Settings& s, bool useClipControl) {
+    cleanup();
+    settings = s;
+    clipControl = useClipControl;
+
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, settings.resolution, settings.resolution,
+                 NUM_CASCADES, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    // Linear filtering with compare mode gives 2x2 PCF per tap
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    const float border[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    glGenFramebuffers(1, &FBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "ERROR: Shadow framebuffer incomplete, status 0x" << std::hex << status << std::dec << std::endl;
+        cleanup();
+        return false;
+    }
+
+    glGenQueries(2, timerQueries);
+    for (Cascade& cascade : cascades) {
+        cascade = Cascade();
+    }
+    return true;
+}
+
+void CascadedShadowMap::computeSplits(float nearPlane, float splits[NUM_CASCADES + 1]) const {
+    // Practical split scheme: blend of logarithmic and uniform
+    float farPlane = settings.shadowDistance;
+    splits[0] = nearPlane;
+    for (int i = 1; i <= NUM_CASCADES; i++) {
+        float t = (float)i / NUM_CASCADES;
+        float logSplit = nearPlane * std::pow(farPlane / nearPlane, t);
+        float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+        splits[i] = settings.splitLambda * logSplit + (1.0f - settings.splitLambda) * uniformSplit;
+    }
+}
+
+void CascadedShadowMap::update(const Matrix4& view, const Vector3& viewPos, float fov, float aspect,
+                               float nearPlane, const Vector3& lightDir, const std::vector<BoundingBox>& patches) {
+    if (depthTexture == 0) return;
+
+    float splits[NUM_CASCADES + 1];
+    computeSplits(nearPlane, splits);
+
+    // Camera axes are the rows of the view rotation
+    Vector3 right(view.m[0], view.m[4], view.m[8]);
+    Vector3 up(view.m[1], view.m[5], view.m[9]);
+    Vector3 forward(-view.m[2], -view.m[6], -view.m[10]);
+    float tanY = std::tan(fov * 0.5f);
+    float tanX = tanY * aspect;
+
+    lightDirection = lightDir.normalized();
+    Matrix4 lightView = makeLightView(lightDirection);
+    float cosThreshold = std::cos(settings.cacheAngle);
+    int cachedUpdates = 0;
+
+    // Patch bounds in the current light space, shared by all re-fitted cascades
+    std::vector<LightBounds> patchBounds(patches.size());
+    for (size_t p = 0; p < patches.size(); p++) {
+        patchBounds[p] = boxInLightSpace(lightView, patches[p]);
+    }
+
+    for (int i = 0; i < NUM_CASCADES; i++) {
+        Cascade& cascade = cascades[i];
+        cascade.splitFar = splits[i + 1];
+
+        Vector3 corners[8];
+        for (int c = 0; c < 8; c++) {
+            float depth = splits[i + (c >> 2)];
+            float sx = (c & 1) ? 1.0f : -1.0f;
+            float sy = (c & 2) ? 1.0f : -1.0f;
+            corners[c] = viewPos + forward * depth + right * (sx * tanX * depth) + up * (sy * tanY * depth);
+        }
+
+        bool cached = i >= settings.firstCachedCascade;
+        if (cached && cascade.valid) {
+            // Still usable if the light barely turned and the slice stays
+            // inside what was rendered
+            LightBounds slice;
+            for (const Vector3& corner : corners) slice.add(transformPoint(cascade.lightView, corner));
+            bool current = lightDirection.dot(cascade.renderedLightDir) >= cosThreshold &&
+                           slice.minX >= cascade.boundsMin[0] && slice.maxX <= cascade.boundsMax[0] &&
+                           slice.minY >= cascade.boundsMin[1] && slice.maxY <= cascade.boundsMax[1];
+            if (current || cachedUpdates >= settings.cachedUpdatesPerFrame) continue;
+            cachedUpdates++;
+        }
+
+        LightBounds slice;
+        for (const Vector3& corner : corners) slice.add(transformPoint(lightView, corner));
+        float lo[2] = { slice.minX, slice.minY };
+        float hi[2] = { slice.maxX, slice.maxY };
+        if (cached) {
+            float marginX = (hi[0] - lo[0]) * settings.cacheMargin;
+            float marginY = (hi[1] - lo[1]) * settings.cacheMargin;
+            lo[0] -= marginX; hi[0] += marginX;
+            lo[1] -= marginY; hi[1] += marginY;
+        }
+
+        // Region the map is valid for; the projection may be tighter
+        cascade.boundsMin[0] = lo[0]; cascade.boundsMin[1] = lo[1];
+        cascade.boundsMax[0] = hi[0]; cascade.boundsMax[1] = hi[1];
+
+        // Terrain-tight fit: casters are the patches under the slice in
+        // light space, including those between it and the light
+        LightBounds casters;
+        for (const LightBounds& patch : patchBounds) {
+            if (!patch.overlapsXY(lo, hi)) continue;
+            casters.minX = std::min(casters.minX, patch.minX); casters.maxX = std::max(casters.maxX, patch.maxX);
+            casters.minY = std::min(casters.minY, patch.minY); casters.maxY = std::max(casters.maxY, patch.maxY);
+            casters.minZ = std::min(casters.minZ, patch.minZ); casters.maxZ = std::max(casters.maxZ, patch.maxZ);
+        }
+        if (casters.minZ > casters.maxZ) {
+            // Nothing under the slice; keep a valid, empty map
+            casters = slice;
+        } else {
+            lo[0] = std::max(lo[0], casters.minX); hi[0] = std::min(hi[0], casters.maxX);
+            lo[1] = std::max(lo[1], casters.minY); hi[1] = std::min(hi[1], casters.maxY);
+        }
+
+        // Snap to whole texels so the map does not shimmer as the camera moves
+        float texelX = std::max(hi[0] - lo[0], 1e-3f) / settings.resolution;
+        float texelY = std::max(hi[1] - lo[1], 1e-3f) / settings.resolution;
+        lo[0] = std::floor(lo[0] / texelX) * texelX; hi[0] = std::ceil(hi[0] / texelX) * texelX;
+        lo[1] = std::floor(lo[1] / texelY) * texelY; hi[1] = std::ceil(hi[1] / texelY) * texelY;
+
+        // Light looks down -z: near/far are the negated caster depths
+        float depthPadding = (casters.maxZ - casters.minZ) * 0.01f + 0.1f;
+        Matrix4 projection = Matrix4::orthographic(lo[0], hi[0], lo[1], hi[1],
+                                                   -casters.maxZ - depthPadding, -casters.minZ + depthPadding);
+
+        cascade.lightView = lightView;
+        cascade.lightViewProj = projection * lightView;
+        cascade.renderedLightDir = lightDirection;
+        cascade.valid = true;
+        cascade.dirty = true;
+    }
+}
+
+void CascadedShadowMap::collectTimerResult() {
+    int slot = frameIndex & 1;
+    if (!queryPending[slot]) return;
+
+    // Issued two frames ago, so normally ready without stalling
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(timerQueries[slot], GL_QUERY_RESULT, &elapsed);
+    gpuTimes.addSample(elapsed / 1.0e6);
+    queryPending[slot] = false;
+}
+
+void CascadedShadowMap::render(const Shader& depthShader, const Mesh& nearMesh, const Mesh& farMesh) {
+    renderedCount = 0;
+    if (depthTexture == 0) return;
+
+    collectTimerResult();
+    int slot = frameIndex & 1;
+    glBeginQuery(GL_TIME_ELAPSED, timerQueries[slot]);
+
+    GLint previousFBO = 0;
+    GLint viewport[4];
+    GLint depthFunc = GL_LESS;
+    GLfloat clearDepth = 1.0f;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFBO);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+    glGetFloatv(GL_DEPTH_CLEAR_VALUE, &clearDepth);
+    GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+
+    // Shadow maps use the conventional depth range, whatever the main pass does
+    glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+    glViewport(0, 0, settings.resolution, settings.resolution);
+    if (clipControl) glClipControl(GL_LOWER_LEFT, GL_NEGATIVE_ONE_TO_ONE);
+    glClearDepth(1.0);
+    glDepthFunc(GL_LEQUAL);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(2.0f, 4.0f);
+
+    // A simplified mesh only pays off when it really is smaller
+    const Mesh& cachedCaster =
+        farMesh.isReady() && farMesh.indices.size() < nearMesh.indices.size() ? farMesh : nearMesh;
+
+    depthShader.use();
+    for (int i = 0; i < NUM_CASCADES; i++) {
+        Cascade& cascade = cascades[i];
+        if (!cascade.dirty) continue;
+
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthTexture, 0, i);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        depthShader.setMat4("lightSpace", cascade.lightViewProj);
+        if (i < settings.firstCachedCascade) {
+            nearMesh.draw();
+        } else {
+            cachedCaster.draw();
+        }
+        cascade.dirty = false;
+        renderedCount++;
+    }
+
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    if (cullFace) glEnable(GL_CULL_FACE);
+    glDepthFunc(depthFunc);
+    glClearDepth(clearDepth);
+    if (clipControl) glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFBO);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    glEndQuery(GL_TIME_ELAPSED);
+    queryPending[slot] = true;
+    frameIndex++;
+
+    totalRendered += renderedCount;
+    framesRendered++;
+}
+
+void CascadedShadowMap::bind(const Shader& shader, const Vector3& viewPos, int textureUnit) const {
+    // Keep the sampler off other units even when unused; two sampler
+    // types on one unit make draws fail
+    shader.setInt("shadowMap", textureUnit);
+    shader.setBool("shadowsEnabled", depthTexture != 0);
+    if (depthTexture == 0) return;
+
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+
+    // Fragment positions are camera-relative: fold the camera offset in
+    Matrix4 toWorld = Matrix4::translation(viewPos);
+    Matrix4 lightMatrices[NUM_CASCADES];
+    for (int i = 0; i < NUM_CASCADES; i++) {
+        lightMatrices[i] = cascades[i].lightViewProj * toWorld;
+    }
+    shader.setMat4Array("lightMatrices", lightMatrices, NUM_CASCADES);
+    shader.setVec4("cascadeSplits", cascades[0].splitFar, cascades[1].splitFar,
+                   cascades[2].splitFar, cascades[3].splitFar);
+    shader.setVec3("sunDirection", lightDirection);
+}
+
+void CascadedShadowMap::report(std::ostream& out) const {
+    gpuTimes.report("Shadow pass (GPU)", out);
+    if (framesRendered > 0) {
+        out << "Shadow cascades rendered per frame: " << (double)totalRendered / framesRendered
+            << " of " << NUM_CASCADES << std::endl;
+    }
+}
+
+void CascadedShadowMap::cleanup() {
+    if (timerQueries[0] != 0) glDeleteQueries(2, timerQueries);
+    if (FBO != 0) glDeleteFramebuffers(1, &FBO);
+    if (depthTexture != 0) glDeleteTextures(1, &depthTexture);
+    timerQueries[0] = timerQueries[1] = 0;
+    queryPending[0] = queryPending[1] = false;
+    FBO = 0;
+    depthTexture = 0;
+}
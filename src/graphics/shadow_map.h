@@ -0,0 +1,97 @@
+#ifndef SHADOW_MAP_H
+#define SHADOW_MAP_H
+
+#include <GL/glew.h>
+#include <vector>
+#include <iostream>
+#include "shader.h"
+#include "mesh.h"
+#include "../math/math.h"
+#include "../core/frame_stats.h"
+
+// Cascaded shadow maps for a directional light, stored as layers of one
+// depth texture array.
+//
+// Each cascade's orthographic bounds are fitted to the terrain: only the
+// patches whose bounds overlap the cascade's view slice contribute, so
+// the light-space box hugs the actual heights instead of the full frustum.
+//
+// Cascades from firstCachedCascade on are cached. They are fitted with
+// a margin and only re-rendered when the light direction turns by more
+// than cacheAngle or the camera slice leaves the cached bounds, and at
+// most cachedUpdatesPerFrame of them per frame.
+class CascadedShadowMap {
+public:
+    static const int NUM_CASCADES = 4;
+
+    struct Settings {
+        int resolution = 2048;
+        float shadowDistance = 400.0f;  // view depth covered by the cascades
+        float splitLambda = 0.75f;      // 0 = uniform splits, 1 = logarithmic
+        int firstCachedCascade = 2;
+        float cacheAngle = 0.05f;       // radians of light rotation before re-render
+        float cacheMargin = 0.25f;      // extra extent of cached cascades, per side
+        int cachedUpdatesPerFrame = 1;  // spreads cached re-renders over frames
+    };
+
+    struct Cascade {
+        Matrix4 lightView;
+        Matrix4 lightViewProj;   // world -> light clip space
+        float splitFar = 0.0f;   // far view depth of the slice
+        float boundsMin[2] = { 0.0f, 0.0f };  // light-space xy the map covers
+        float boundsMax[2] = { 0.0f, 0.0f };
+        Vector3 renderedLightDir;
+        bool valid = false;
+        bool dirty = true;
+    };
+
+    Settings settings;
+    Cascade cascades[NUM_CASCADES];
+
+    CascadedShadowMap();
+    ~CascadedShadowMap();
+
+    // clipControl: the depth range is [0, 1] (glClipControl), as with reverse-Z
+    bool create(const Settings& settings, bool clipControl);
+
+    // Fits the cascades to the camera slices. lightDir points towards the
+    // light; patches are world-space bounds of the shadow casters.
+    void update(const Matrix4& view, const Vector3& viewPos, float fov, float aspect,
+                float nearPlane, const Vector3& lightDir, const std::vector<BoundingBox>& patches);
+
+    // Renders the dirty cascades. Near cascades use nearMesh; cached ones
+    // use farMesh when it is ready and has fewer indices, else nearMesh.
+    // Restores the framebuffer and viewport.
+    void render(const Shader& depthShader, const Mesh& nearMesh, const Mesh& farMesh);
+
+    // Binds the depth array and sets the sampling uniforms. Light matrices
+    // are made camera-relative to match the terrain shader.
+    void bind(const Shader& shader, const Vector3& viewPos, int textureUnit) const;
+
+    int renderedLastFrame() const { return renderedCount; }
+
+    // GPU time of the shadow pass per frame, from timer queries
+    const FrameStats& passTimes() const { return gpuTimes; }
+    void report(std::ostream& out = std::cout) const;
+
+    void cleanup();
+
+private:
+    GLuint depthTexture;
+    GLuint FBO;
+    GLuint timerQueries[2];
+    bool queryPending[2];
+    int frameIndex;
+    bool clipControl;
+
+    int renderedCount;
+    long long totalRendered;
+    long long framesRendered;
+    Vector3 lightDirection;
+    FrameStats gpuTimes;
+
+    void computeSplits(float nearPlane, float splits[NUM_CASCADES + 1]) const;
+    void collectTimerResult();
+};
+
+#endif // SHADOW_MAP_H
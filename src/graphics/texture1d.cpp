@@ -0,0 +1,28 @@
+#include "texture1d.h"
+
+Texture1D::Texture1D() : ID(0) {}
+
+Texture1D::~Texture1D() {
+    cleanup();
+}
+
+void Texture1D::create(const float* rgb, int size) {
+    cleanup();
+    glGenTextures(1, &ID);
+    glBindTexture(GL_TEXTURE_1D, ID);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB16F, size, 0, GL_RGB, GL_FLOAT, rgb);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_1D, 0);
+}
+
+void Texture1D::bind(int unit) const {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_1D, ID);
+}
+
+void Texture1D::cleanup() {
+    if (ID != 0) glDeleteTextures(1, &ID);
+    ID = 0;
+}
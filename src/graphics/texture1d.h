@@ -0,0 +1,19 @@
+#ifndef TEXTURE1D_H
+#define TEXTURE1D_H
+
+#include <GL/glew.h>
+
+// RGB float 1D texture with linear filtering and clamped edges
+class Texture1D {
+public:
+    GLuint ID;
+
+    Texture1D();
+    ~Texture1D();
+
+    void create(const float* rgb, int size);
+    void bind(int unit) const;
+    void cleanup();
+};
+
+#endif // TEXTURE1D_H
@@ -0,0 +1,24 @@
+#include "upload_queue.h"
+
+UploadQueue::UploadQueue() : current(nullptr) {}
+
+void UploadQueue::push(Mesh* mesh) {
+    pending.push(mesh);
+}
+
+size_t UploadQueue::process(size_t budgetBytes) {
+    size_t uploaded = 0;
+
+    while (uploaded < budgetBytes) {
+        if (!current) {
+            if (!pending.pop(current)) break;
+            current->beginUpload();
+        }
+
+        uploaded += current->uploadChunk(budgetBytes - uploaded);
+        if (!current->isUploading()) {
+            current = nullptr;
+        }
+    }
+    return uploaded;
+}
@@ -0,0 +1,28 @@
+#ifndef UPLOAD_QUEUE_H
+#define UPLOAD_QUEUE_H
+
+#include <cstddef>
+#include "mesh.h"
+#include "../core/mpsc_queue.h"
+
+// Hands finished meshes from worker threads to the render thread. Only
+// the render thread calls process(), which copies at most the given byte
+// budget into GL buffers per call so large meshes spread over frames.
+class UploadQueue {
+public:
+    UploadQueue();
+
+    // Any thread. The mesh must not be modified after it is pushed.
+    void push(Mesh* mesh);
+
+    // Render thread only. Returns the bytes uploaded this call.
+    size_t process(size_t budgetBytes);
+
+    bool idle() const { return current == nullptr; }
+
+private:
+    MpscQueue<Mesh*> pending;
+    Mesh* current;
+};
+
+#endif // UPLOAD_QUEUE_H
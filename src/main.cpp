@@ -2,18 +2,152 @@
 #include <GLFW/glfw3.h>
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
 
 #include "math/math.h"
 #include "graphics/shader.h"
 #include "graphics/camera.h"
 #include "terrain/terrain.h"
+#include "core/frame_stats.h"
+#include "core/job_system.h"
+#include "core/frame_scheduler.h"
+#include "graphics/upload_queue.h"
+#include "graphics/texture1d.h"
+#include "graphics/render_target.h"
+#include "graphics/shadow_map.h"
+#include "export/terrain_exporter.h"
+
+#ifdef TERRAIN_HEADLESS
+#include "graphics/headless_context.h"
+#include "graphics/png_writer.h"
+#endif
 
 // Global variables
 Camera camera;
 double lastX = 400, lastY = 300;
 bool firstMouse = true;
-float deltaTime = 0.0f;
-float lastFrame = 0.0f;
+
+// Bytes of mesh data copied to the GPU per frame while terrain streams in
+const size_t UPLOAD_BUDGET_PER_FRAME = 4 * 1024 * 1024;
+
+// Camera projection, shared by the main pass and shadow cascade fitting
+const float CAMERA_FOV = 45.0f * PI / 180.0f;
+const float CAMERA_NEAR = 0.1f;
+
+// Background budget for baking ambient occlusion on a 4096x4096 grid,
+// as measured with one worker (7.5-8.2 s); other sizes scale it by
+// sample count. More workers should only come in under it.
+const double OCCLUSION_BUDGET_MS_4K = 8500.0;
+
+// Simulation rate, independent of the display rate
+const double SIMULATION_STEP = 1.0 / 120.0;
+
+// Seconds between latency reports in the windowed loop
+const double LATENCY_REPORT_INTERVAL = 10.0;
+
+// Command line options
+struct AppOptions {
+    bool headless = false;
+    int frames = 600;
+    int width = 1280;
+    int height = 720;
+    std::string snapshotDir;
+    int snapshotEvery = 0;
+    std::string colorRampPath = "src/config/color_ramp.txt";
+    bool vertexColors = false;
+    std::string exportDir;
+    int exportSize = 200;
+    float exportError = 0.0f;
+    bool reverseZ = true;
+    bool shadows = true;
+    int occlusionBenchmark = 0;
+    bool vsync = true;
+    double fpsLimit = 0.0;
+    bool finishAfterSwap = false;
+};
+
+// Per-frame camera and lighting inputs for drawScene()
+struct SceneView {
+    Matrix4 view;
+    Vector3 viewPos;
+    Matrix4 projection;
+    Vector3 lightPos;
+    Vector3 lightColor;
+};
+
+static void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --headless            Render offscreen and report frame timings\n"
+              << "  --frames N            Number of frames in headless mode (default 600)\n"
+              << "  --size WxH            Framebuffer size (default 1280x720)\n"
+              << "  --snapshot-dir DIR    Write PNG snapshots into DIR (headless only)\n"
+              << "  --snapshot-every N    Snapshot every N frames (default: first and last)\n"
+              << "  --color-ramp FILE     Height color ramp (default src/config/color_ramp.txt)\n"
+              << "  --vertex-colors       Bake colors into vertices instead of a ramp texture\n"
+              << "  --export DIR          Write terrain.trn, terrain.glb and heightmap.png into DIR and exit\n"
+              << "  --export-size N       Grid resolution for --export (default 200)\n"
+              << "  --export-error E      Simplify terrain.glb to max vertical error E; holds the grid in memory (default 0, streamed)\n"
+              << "  --no-reverse-z        Use a standard depth buffer with a 1000 unit far plane\n"
+              << "  --no-shadows          Disable cascaded shadow maps\n"
+              << "  --ao-benchmark N      Time the ambient occlusion bake on an NxN grid (e.g. 4096) and exit\n"
+              << "  --no-vsync            Do not wait for vertical sync when presenting\n"
+              << "  --fps-limit N         Cap the frame rate by sleeping (default off)\n"
+              << "  --finish-after-swap   Wait for the GPU after each swap so latency covers presentation" << std::endl;
+}
+
+static bool parseArgs(int argc, char** argv, AppOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--frames" && hasValue) {
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--size" && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 ||
+                options.width <= 0 || options.height <= 0) {
+                std::cerr << "Invalid size: " << argv[i] << std::endl;
+                return false;
+            }
+        } else if (arg == "--snapshot-dir" && hasValue) {
+            options.snapshotDir = argv[++i];
+        } else if (arg == "--snapshot-every" && hasValue) {
+            options.snapshotEvery = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--color-ramp" && hasValue) {
+            options.colorRampPath = argv[++i];
+        } else if (arg == "--vertex-colors") {
+            options.vertexColors = true;
+        } else if (arg == "--export" && hasValue) {
+            options.exportDir = argv[++i];
+        } else if (arg == "--export-size" && hasValue) {
+            options.exportSize = std::max(2, std::atoi(argv[++i]));
+        } else if (arg == "--export-error" && hasValue) {
+            options.exportError = std::max(0.0f, (float)std::atof(argv[++i]));
+        } else if (arg == "--no-reverse-z") {
+            options.reverseZ = false;
+        } else if (arg == "--no-shadows") {
+            options.shadows = false;
+        } else if (arg == "--ao-benchmark" && hasValue) {
+            options.occlusionBenchmark = std::max(2, std::atoi(argv[++i]));
+        } else if (arg == "--no-vsync") {
+            options.vsync = false;
+        } else if (arg == "--fps-limit" && hasValue) {
+            options.fpsLimit = std::max(0.0, std::atof(argv[++i]));
+        } else if (arg == "--finish-after-swap") {
+            options.finishAfterSwap = true;
+        } else {
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
 
 // Mouse callback
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -43,7 +177,295 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         glfwSetWindowShouldClose(window, true);
 }
 
-int main() {
+// Light orbits the terrain
+static Vector3 animateLight(float time) {
+    float angle = time * 0.3f;
+    return Vector3(150.0f * std::cos(angle), 100.0f + 50.0f * std::sin(angle * 0.5f), 150.0f * std::sin(angle));
+}
+
+// Reverse-Z needs a [0, 1] clip depth range to benefit from float depth
+static bool supportsReverseZ() {
+    return GLEW_VERSION_4_5 || GLEW_ARB_clip_control;
+}
+
+static void initRenderState(bool reverseZ) {
+    glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+
+    // Enable depth testing
+    glEnable(GL_DEPTH_TEST);
+    if (reverseZ) {
+        // Near plane at depth 1, infinity at 0
+        glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+        glClearDepth(0.0);
+        glDepthFunc(GL_GEQUAL);
+    } else {
+        glDepthFunc(GL_LEQUAL);
+    }
+
+    // Enable backface culling
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+
+    std::cout << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
+    std::cout << "GLSL Version: " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
+    std::cout << "Depth: " << (reverseZ ? "reverse-Z, 32-bit float, infinite far plane" : "standard, far plane 1000")
+              << std::endl;
+}
+
+static Matrix4 makeProjection(float aspect, bool reverseZ) {
+    if (reverseZ) {
+        return Matrix4::perspectiveReverseZ(CAMERA_FOV, aspect, CAMERA_NEAR);
+    }
+    return Matrix4::perspective(CAMERA_FOV, aspect, CAMERA_NEAR, 1000.0f);
+}
+
+// Shadow map and depth shader; the map stays empty when disabled
+static void initShadows(CascadedShadowMap& shadows, Shader& depthShader, const AppOptions& options, bool reverseZ) {
+    if (!options.shadows) return;
+    depthShader.compile("src/shaders/shadow_depth.vert", "src/shaders/shadow_depth.frag");
+    if (!shadows.create(CascadedShadowMap::Settings(), reverseZ)) {
+        std::cerr << "Shadows disabled" << std::endl;
+    }
+}
+
+// Fits and renders the dirty cascades once the terrain is on the GPU. The
+// sun direction is taken from the light position over the terrain center.
+static void renderShadows(CascadedShadowMap& shadows, const Shader& depthShader, const Terrain& terrain,
+                          const SceneView& scene, float aspect) {
+    // patchBounds is written by a job; tilesReady() publishes it too
+    if (!terrain.tilesReady() || !terrain.mesh.isReady()) return;
+    shadows.update(scene.view, scene.viewPos, CAMERA_FOV, aspect, CAMERA_NEAR, scene.lightPos, terrain.patchBounds);
+    shadows.render(depthShader, terrain.mesh, terrain.lodMesh);
+}
+
+// Color ramp from the config file; falls back to the built-in ramp
+static void configureTerrain(Terrain& terrain, Texture1D& rampTexture, const AppOptions& options) {
+    terrain.colorRamp.loadFromFile(options.colorRampPath);
+    terrain.gpuColors = !options.vertexColors;
+    rampTexture.create(terrain.colorRamp.lutData(), ColorRamp::LUT_SIZE);
+}
+
+static void drawScene(const Shader& shader, const Terrain& terrain, const Texture1D& rampTexture,
+                      const CascadedShadowMap& shadows, const SceneView& scene) {
+    // Clear
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Use shader
+    shader.use();
+
+    // Set matrices. The camera offset is folded into modelRelative so the
+    // shaders light and shadow in camera-relative space. Vertex positions
+    // are absolute, so the GPU still subtracts two world-sized floats; that
+    // is harmless for a terrain of `scale` units centered at the origin,
+    // but large worlds would need positions relative to a tile origin.
+    Matrix4 model = Matrix4::identity();
+    Matrix4 modelRelative = model;
+    modelRelative.m[12] -= scene.viewPos.x;
+    modelRelative.m[13] -= scene.viewPos.y;
+    modelRelative.m[14] -= scene.viewPos.z;
+
+    Matrix4 viewRotation = scene.view;
+    viewRotation.m[12] = 0.0f;
+    viewRotation.m[13] = 0.0f;
+    viewRotation.m[14] = 0.0f;
+
+    shader.setMat4("model", model);
+    shader.setMat4("modelRelative", modelRelative);
+    shader.setMat4("view", viewRotation);
+    shader.setMat4("projection", scene.projection);
+
+    // Set lighting (camera-relative)
+    shader.setVec3("viewPos", Vector3(0.0f, 0.0f, 0.0f));
+    shader.setVec3("lightPos", scene.lightPos - scene.viewPos);
+    shader.setVec3("lightColor", scene.lightColor);
+
+    // Height colors
+    rampTexture.bind(0);
+    shader.setInt("colorRamp", 0);
+    shader.setBool("useColorRamp", terrain.gpuColors);
+    shader.setFloat("heightScale", terrain.heightScale);
+
+    // Shadows
+    shadows.bind(shader, scene.viewPos, 1);
+
+    // Draw terrain
+    terrain.draw(scene.viewPos);
+}
+
+// Streams the terrain to disk without a GL context. Heights are sampled
+// from noise row by row, so large grids never build a full mesh. Only
+// --export-error opts into a simplified glTF, which loads the whole
+// height grid plus the simplifier's padded grids.
+static int runExport(const AppOptions& options) {
+    Terrain terrain(options.exportSize, options.exportSize, 200.0f, 80.0f);
+    TerrainExporter exporter = TerrainExporter::fromTerrain(terrain);
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = exporter.writeTiled(options.exportDir + "/terrain.trn") &&
+              exporter.writeGlb(options.exportDir + "/terrain.glb", options.exportError) &&
+              exporter.writeHeightmapPng(options.exportDir + "/heightmap.png");
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Export of " << options.exportSize << "x" << options.exportSize << " grid "
+              << (ok ? "finished" : "failed") << " in " << seconds << " s" << std::endl;
+    return ok ? 0 : -1;
+}
+
+// Times the ambient occlusion bake on noise heights against the budget.
+// Needs no GL context.
+static int runOcclusionBenchmark(const AppOptions& options) {
+    int size = options.occlusionBenchmark;
+    Terrain terrain(size, size, 200.0f, 80.0f);
+    JobSystem jobs;
+
+    std::vector<float> heights((size_t)size * size);
+    jobs.wait(jobs.parallelFor(0, size, 16, [&terrain, &heights, size](int zBegin, int zEnd) {
+        for (int z = zBegin; z < zEnd; z++) terrain.sampleRow(z, &heights[(size_t)z * size]);
+    }));
+
+    auto start = std::chrono::steady_clock::now();
+    AmbientOcclusionBaker baker;
+    baker.build(heights, size, size, terrain.scale / (size - 1), terrain.scale / (size - 1));
+    auto built = std::chrono::steady_clock::now();
+    std::vector<unsigned char> occlusion = baker.bake(&jobs);
+    auto end = std::chrono::steady_clock::now();
+
+    double pyramidMs = std::chrono::duration<double, std::milli>(built - start).count();
+    double totalMs = std::chrono::duration<double, std::milli>(end - start).count();
+    double samples = (double)size * size;
+    double budgetMs = OCCLUSION_BUDGET_MS_4K * samples / (4096.0 * 4096.0);
+
+    std::cout << "Ambient occlusion bake: " << size << "x" << size << " grid, " << baker.levelCount()
+              << " pyramid levels, " << jobs.workerCount() << " workers\n"
+              << "  pyramid " << pyramidMs << " ms, total " << totalMs << " ms ("
+              << totalMs * 1.0e6 / samples << " ns/sample)\n"
+              << "  budget " << budgetMs << " ms: " << (totalMs <= budgetMs ? "within" : "OVER") << std::endl;
+    return 0;
+}
+
+#ifdef TERRAIN_HEADLESS
+// Offscreen benchmark: flies a fixed orbit around the terrain with no vsync,
+// timing each frame to completion with glFinish()
+static int runHeadless(const AppOptions& options) {
+    HeadlessContext context;
+    if (!context.create(3, 3)) {
+        return -1;
+    }
+
+    // GLEW built for GLX reports a missing display on EGL contexts but
+    // still resolves the entry points
+    glewExperimental = GL_TRUE;
+    GLenum glewStatus = glewInit();
+    if (glewStatus != GLEW_OK && glewStatus != GLEW_ERROR_NO_GLX_DISPLAY) {
+        std::cerr << "Failed to initialize GLEW" << std::endl;
+        return -1;
+    }
+
+    bool reverseZ = options.reverseZ && supportsReverseZ();
+    RenderTarget target;
+    if (!target.create(options.width, options.height, reverseZ ? GL_DEPTH_COMPONENT32F : GL_DEPTH_COMPONENT24)) {
+        return -1;
+    }
+    initRenderState(reverseZ);
+
+    Shader terrainShader;
+    terrainShader.compile("src/shaders/terrain.vert", "src/shaders/terrain.frag");
+
+    Terrain terrain(200, 200, 200.0f, 80.0f);
+    Texture1D rampTexture;
+    configureTerrain(terrain, rampTexture, options);
+    JobSystem jobs;
+    terrain.generate(jobs);
+
+    CascadedShadowMap shadows;
+    Shader shadowShader;
+    initShadows(shadows, shadowShader, options, reverseZ);
+
+    SceneView scene;
+    scene.lightColor = Vector3(1.0f, 1.0f, 1.0f);
+    float aspect = (float)options.width / (float)options.height;
+    scene.projection = makeProjection(aspect, reverseZ);
+    Vector3 center(0.0f, 20.0f, 0.0f);
+    const float simulatedStep = 1.0f / 60.0f;
+
+    FrameStats frameTimes(options.frames);
+    std::vector<unsigned char> pixels;
+
+    auto benchStart = std::chrono::steady_clock::now();
+    double snapshotMs = 0.0;
+
+    for (int frame = 0; frame < options.frames; frame++) {
+        auto frameStart = std::chrono::steady_clock::now();
+
+        // One full orbit over the run
+        float t = (float)frame / (float)options.frames;
+        float angle = t * 2.0f * PI;
+        scene.viewPos = Vector3(130.0f * std::cos(angle), 70.0f + 20.0f * std::sin(angle * 2.0f), 130.0f * std::sin(angle));
+        scene.view = Matrix4::lookAt(scene.viewPos, center, Vector3(0.0f, 1.0f, 0.0f));
+        scene.lightPos = animateLight(frame * simulatedStep);
+
+        target.bind();
+        renderShadows(shadows, shadowShader, terrain, scene, aspect);
+        drawScene(terrainShader, terrain, rampTexture, shadows, scene);
+        glFinish();
+
+        auto frameEnd = std::chrono::steady_clock::now();
+        frameTimes.addSample(std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+
+        bool finalFrame = frame == options.frames - 1;
+        bool snapshot = !options.snapshotDir.empty() &&
+            (options.snapshotEvery > 0 ? frame % options.snapshotEvery == 0 : (frame == 0 || finalFrame));
+        if (snapshot) {
+            char name[64];
+            std::snprintf(name, sizeof(name), "/frame_%05d.png", frame);
+            target.readPixels(pixels);
+            if (!PngWriter::writeRGBA8(options.snapshotDir + name, target.width, target.height, pixels.data())) {
+                std::cerr << "Failed to write snapshot " << options.snapshotDir + name << std::endl;
+            }
+            snapshotMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameEnd).count();
+        }
+    }
+
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - benchStart).count();
+    double renderMs = elapsedMs - snapshotMs;
+
+    std::cout << "Headless benchmark: " << options.frames << " frames at " << options.width << "x" << options.height
+              << ", " << (options.frames * 1000.0 / renderMs) << " frames/sec" << std::endl;
+    frameTimes.report("Frame time");
+    shadows.report();
+
+    terrain.mesh.cleanup();
+    terrain.lodMesh.cleanup();
+    rampTexture.cleanup();
+    shadows.cleanup();
+    target.cleanup();
+    return 0;
+}
+#endif
+
+int main(int argc, char** argv) {
+    AppOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        return -1;
+    }
+
+    if (!options.exportDir.empty()) {
+        return runExport(options);
+    }
+
+    if (options.occlusionBenchmark > 0) {
+        return runOcclusionBenchmark(options);
+    }
+
+    if (options.headless) {
+#ifdef TERRAIN_HEADLESS
+        return runHeadless(options);
+#else
+        std::cerr << "Headless mode is not available in this build (TERRAIN_HEADLESS=OFF)" << std::endl;
+        return -1;
+#endif
+    }
+
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -56,8 +478,8 @@ int main() {
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
     // Create window
-    const int WIDTH = 1280;
-    const int HEIGHT = 720;
+    const int WIDTH = options.width;
+    const int HEIGHT = options.height;
     GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "3D Terrain Generator", NULL, NULL);
     if (!window) {
         std::cerr << "Failed to create GLFW window" << std::endl;
@@ -70,7 +492,7 @@ int main() {
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
     glfwSetKeyCallback(window, key_callback);
-    glfwSwapInterval(1); // V-Sync
+    glfwSwapInterval(options.vsync ? 1 : 0);
 
     // Initialize GLEW
     glewExperimental = GL_TRUE;
@@ -81,93 +503,116 @@ int main() {
 
     // Set viewport
     glViewport(0, 0, WIDTH, HEIGHT);
-    glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
-
-    // Enable depth testing
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LEQUAL);
-
-    // Enable backface culling
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+    bool reverseZ = options.reverseZ && supportsReverseZ();
+    initRenderState(reverseZ);
 
-    std::cout << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
-    std::cout << "GLSL Version: " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
+    // The default framebuffer has fixed-point depth; reverse-Z renders into
+    // a float depth target and blits the color to the window
+    RenderTarget sceneTarget;
+    if (reverseZ && !sceneTarget.create(WIDTH, HEIGHT, GL_DEPTH_COMPONENT32F)) {
+        return -1;
+    }
 
     // Load shaders
     Shader terrainShader;
     terrainShader.compile("src/shaders/terrain.vert", "src/shaders/terrain.frag");
 
-    // Generate terrain
+    CascadedShadowMap shadows;
+    Shader shadowShader;
+    initShadows(shadows, shadowShader, options, reverseZ);
+
+    // Generate terrain in the background; the mesh appears once uploaded
     std::cout << "Generating terrain..." << std::endl;
     Terrain terrain(200, 200, 200.0f, 80.0f);
-    terrain.generate();
-    std::cout << "Terrain generated successfully!" << std::endl;
+    Texture1D rampTexture;
+    configureTerrain(terrain, rampTexture, options);
+    UploadQueue uploads;
+    JobSystem jobs;
+    terrain.generateAsync(jobs, uploads);
 
     // Initialize camera
     camera = Camera(Vector3(100.0f, 80.0f, 100.0f), Vector3(0.0f, 1.0f, 0.0f));
 
     // Lighting setup
-    Vector3 lightPos(150.0f, 150.0f, 150.0f);
-    Vector3 lightColor(1.0f, 1.0f, 1.0f);
+    SceneView scene;
+    scene.lightPos = Vector3(150.0f, 150.0f, 150.0f);
+    scene.lightColor = Vector3(1.0f, 1.0f, 1.0f);
+    const float aspect = (float)WIDTH / (float)HEIGHT;
+    scene.projection = makeProjection(aspect, reverseZ);
+
+    // Fixed-step simulation with interpolated rendering
+    FrameScheduler scheduler(SIMULATION_STEP);
+    scheduler.setFrameLimit(options.fpsLimit);
+    scheduler.setSwapWaits(options.finishAfterSwap);
+    Vector3 previousPosition = camera.position;
+    double lastLatencyReport = glfwGetTime();
 
     // Main render loop
     while (!glfwWindowShouldClose(window)) {
-        float currentFrame = (float)glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // Input handling
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-            camera.processKeyboard(GLFW_KEY_W, deltaTime);
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-            camera.processKeyboard(GLFW_KEY_S, deltaTime);
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-            camera.processKeyboard(GLFW_KEY_A, deltaTime);
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-            camera.processKeyboard(GLFW_KEY_D, deltaTime);
-
-        // Animate light
-        float angle = (float)glfwGetTime() * 0.3f;
-        lightPos.x = 150.0f * std::cos(angle);
-        lightPos.z = 150.0f * std::sin(angle);
-        lightPos.y = 100.0f + 50.0f * std::sin(angle * 0.5f);
-
-        // Clear
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Use shader
-        terrainShader.use();
-
-        // Set matrices
-        Matrix4 model = Matrix4::identity();
-        Matrix4 view = camera.getViewMatrix();
-        Matrix4 projection = Matrix4::perspective(
-            45.0f * PI / 180.0f,
-            (float)WIDTH / (float)HEIGHT,
-            0.1f,
-            1000.0f
-        );
-
-        terrainShader.setMat4("model", model);
-        terrainShader.setMat4("view", view);
-        terrainShader.setMat4("projection", projection);
-
-        // Set lighting
-        terrainShader.setVec3("viewPos", camera.position);
-        terrainShader.setVec3("lightPos", lightPos);
-        terrainShader.setVec3("lightColor", lightColor);
-
-        // Draw terrain
-        terrain.draw();
-
-        // Swap buffers
-        glfwSwapBuffers(window);
+        // Wait for the frame slot first so input is sampled fresh
+        scheduler.waitForFrame();
         glfwPollEvents();
+
+        // Keyboard movement advances in equal steps; the previous position
+        // is kept for interpolation
+        scheduler.beginFrame();
+        while (scheduler.nextStep()) {
+            float step = (float)scheduler.step();
+            previousPosition = camera.position;
+            if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+                camera.processKeyboard(GLFW_KEY_W, step);
+            if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+                camera.processKeyboard(GLFW_KEY_S, step);
+            if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+                camera.processKeyboard(GLFW_KEY_A, step);
+            if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+                camera.processKeyboard(GLFW_KEY_D, step);
+        }
+
+        // Stream finished meshes to the GPU
+        uploads.process(UPLOAD_BUDGET_PER_FRAME);
+
+        // Late-latch: pick up mouse look that arrived during the frame's
+        // CPU work, right before the view is built for the shadow and
+        // main passes
+        glfwPollEvents();
+        scheduler.latchInput();
+        // Deliberate mix: rotation is the freshest latched state, position
+        // is interpolated. It only works because drawScene() and the
+        // shadow cascades take the view's rotation alone and translate by
+        // scene.viewPos; anything using view.m[12..14] would be off by up
+        // to one simulation step.
+        scene.view = camera.getViewMatrix();
+        scene.viewPos = Vector3::lerp(previousPosition, camera.position, (float)scheduler.alpha());
+        scene.lightPos = animateLight((float)scheduler.interpolatedTime());
+
+        if (reverseZ) sceneTarget.bind();
+        renderShadows(shadows, shadowShader, terrain, scene, aspect);
+        drawScene(terrainShader, terrain, rampTexture, shadows, scene);
+        if (reverseZ) sceneTarget.blitToDefault(WIDTH, HEIGHT);
+
+        // Swap buffers. The swap usually returns before the frame is shown;
+        // glFinish() blocks until it has executed, at the cost of the CPU
+        // no longer running ahead of the GPU.
+        glfwSwapBuffers(window);
+        if (options.finishAfterSwap) glFinish();
+        scheduler.frameSwapped();
+
+        if (glfwGetTime() - lastLatencyReport >= LATENCY_REPORT_INTERVAL) {
+            scheduler.report();
+            lastLatencyReport = glfwGetTime();
+        }
     }
 
+    scheduler.report();
+    shadows.report();
+
     // Cleanup
     terrain.mesh.cleanup();
+    terrain.lodMesh.cleanup();
+    rampTexture.cleanup();
+    shadows.cleanup();
+    sceneTarget.cleanup();
     glfwTerminate();
 
     std::cout << "Application closed successfully!" << std::endl;
@@ -54,6 +54,7 @@ public:
     static Matrix4 scale(float x, float y, float z);
     static Matrix4 scale(const Vector3& s);
     static Matrix4 perspective(float fov, float aspect, float near, float far);
+    static Matrix4 perspectiveReverseZ(float fov, float aspect, float near);
     static Matrix4 orthographic(float left, float right, float bottom, float top, float near, float far);
     static Matrix4 lookAt(const Vector3& eye, const Vector3& center, const Vector3& up);
 
@@ -66,7 +67,7 @@ public:
     void rotateX(float angle);
     void rotateY(float angle);
     void rotateZ(float angle);
-    void scale(float x, float y, float z);
+    void scaleBy(float x, float y, float z);
 
     Matrix4 transpose() const;
     Matrix4 inverse() const;
@@ -74,6 +75,26 @@ public:
     void print(const std::string& name = "") const;
 };
 
+// Reverse-Z projection with an infinite far plane for a [0, 1] clip depth
+// range (glClipControl): depth = near / distance, so the near plane maps to
+// 1 and infinity to 0, matching the precision distribution of float depth.
+inline Matrix4 Matrix4::perspectiveReverseZ(float fov, float aspect, float near) {
+    float f = 1.0f / std::tan(fov / 2.0f);
+
+    Matrix4 result;
+    for (int i = 0; i < 16; i++) result.m[i] = 0.0f;
+    result.m[0] = f / aspect;
+    result.m[5] = f;
+    result.m[11] = -1.0f;
+    result.m[14] = near;
+    return result;
+}
+
+// Axis-aligned box
+struct BoundingBox {
+    Vector3 min, max;
+};
+
 class Quaternion {
 public:
     float w, x, y, z;
@@ -0,0 +1,104 @@
+#include "math.h"
+
+// Out-of-line Vector3 members declared in math.h. math.cpp defines its
+// own standalone classes and does not implement this header.
+
+Vector3::Vector3() : x(0), y(0), z(0) {}
+
+Vector3::Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+Vector3::Vector3(const Vector3& v) : x(v.x), y(v.y), z(v.z) {}
+
+Vector3 Vector3::operator+(const Vector3& v) const {
+    return Vector3(x + v.x, y + v.y, z + v.z);
+}
+
+Vector3 Vector3::operator-(const Vector3& v) const {
+    return Vector3(x - v.x, y - v.y, z - v.z);
+}
+
+Vector3 Vector3::operator*(float scalar) const {
+    return Vector3(x * scalar, y * scalar, z * scalar);
+}
+
+Vector3 Vector3::operator/(float scalar) const {
+    return Vector3(x / scalar, y / scalar, z / scalar);
+}
+
+Vector3& Vector3::operator+=(const Vector3& v) {
+    x += v.x;
+    y += v.y;
+    z += v.z;
+    return *this;
+}
+
+Vector3& Vector3::operator-=(const Vector3& v) {
+    x -= v.x;
+    y -= v.y;
+    z -= v.z;
+    return *this;
+}
+
+Vector3& Vector3::operator*=(float scalar) {
+    x *= scalar;
+    y *= scalar;
+    z *= scalar;
+    return *this;
+}
+
+Vector3& Vector3::operator/=(float scalar) {
+    x /= scalar;
+    y /= scalar;
+    z /= scalar;
+    return *this;
+}
+
+Vector3 Vector3::operator-() const {
+    return Vector3(-x, -y, -z);
+}
+
+float Vector3::dot(const Vector3& v) const {
+    return x * v.x + y * v.y + z * v.z;
+}
+
+Vector3 Vector3::cross(const Vector3& v) const {
+    return Vector3(
+        y * v.z - z * v.y,
+        z * v.x - x * v.z,
+        x * v.y - y * v.x
+    );
+}
+
+float Vector3::length() const {
+    return std::sqrt(x * x + y * y + z * z);
+}
+
+float Vector3::lengthSquared() const {
+    return x * x + y * y + z * z;
+}
+
+Vector3 Vector3::normalized() const {
+    float len = length();
+    if (len > EPSILON) {
+        return Vector3(x / len, y / len, z / len);
+    }
+    return *this;
+}
+
+void Vector3::normalize() {
+    float len = length();
+    if (len > EPSILON) {
+        x /= len;
+        y /= len;
+        z /= len;
+    }
+}
+
+Vector3 Vector3::lerp(const Vector3& a, const Vector3& b, float t) {
+    return Vector3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+}
+
+void Vector3::print(const std::string& name) const {
+    if (!name.empty()) std::cout << name << ": ";
+    std::cout << std::fixed << std::setprecision(3) << "(" << x << ", " << y << ", " << z << ")" << std::endl;
+}
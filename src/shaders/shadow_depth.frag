@@ -0,0 +1,5 @@
+
+// Depth-only pass: the depth attachment is all that is written
+void main()
+{
+}
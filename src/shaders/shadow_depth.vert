@@ -0,0 +1,9 @@
+
+layout(location = 0) in vec3 position;
+
+uniform mat4 lightSpace;  // world -> light clip space of one cascade
+
+void main()
+{
+    gl_Position = lightSpace * vec4(position, 1.0);
+}
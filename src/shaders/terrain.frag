@@ -2,22 +2,80 @@
 in vec3 FragPos;
 in vec3 Normal;
 in vec3 VertexColor;
+in float Height;
+in float ViewDepth;
+in float Occlusion;
 
 out vec4 FragColor;
 
+// Positions are camera-relative, so viewPos is normally the origin
 uniform vec3 viewPos;
 uniform vec3 lightPos;
 uniform vec3 lightColor;
 
+// Height color ramp, used when the mesh carries no vertex colors
+uniform bool useColorRamp;
+uniform sampler1D colorRamp;
+uniform float heightScale;
+
+// Cascaded shadows from the directional sun
+uniform bool shadowsEnabled;
+uniform sampler2DArrayShadow shadowMap;
+uniform mat4 lightMatrices[4];  // camera-relative position -> light clip space
+uniform vec4 cascadeSplits;     // far view depth of each cascade
+uniform vec3 sunDirection;      // towards the light
+
+float shadowFactor(vec3 norm, vec3 lightDir)
+{
+    if (!shadowsEnabled || ViewDepth > cascadeSplits.w) return 1.0;
+
+    int cascade = 3;
+    for (int i = 0; i < 3; i++) {
+        if (ViewDepth <= cascadeSplits[i]) {
+            cascade = i;
+            break;
+        }
+    }
+
+    vec4 lightSpace = lightMatrices[cascade] * vec4(FragPos, 1.0);
+    vec3 coords = lightSpace.xyz / lightSpace.w * 0.5 + 0.5;
+    if (coords.z > 1.0) return 1.0;
+
+    // Slope-scaled bias against acne on grazing terrain
+    float bias = max(0.002 * (1.0 - dot(norm, lightDir)), 0.0005);
+
+    // 3x3 taps, each a hardware 2x2 PCF lookup
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for (int x = -1; x <= 1; x++) {
+        for (int y = -1; y <= 1; y++) {
+            lit += texture(shadowMap, vec4(coords.xy + vec2(x, y) * texel, float(cascade), coords.z - bias));
+        }
+    }
+    return lit / 9.0;
+}
+
 void main()
 {
-    // Ambient
-    float ambientStrength = 0.2;
+    // Base color
+    vec3 baseColor = VertexColor;
+    if (useColorRamp) {
+        // Map [0, 1] onto the first and last texel centers
+        float size = float(textureSize(colorRamp, 0));
+        float t = clamp(Height / heightScale, 0.0, 1.0);
+        baseColor = texture(colorRamp, (t * (size - 1.0) + 0.5) / size).rgb;
+    }
+
+    // Ambient, darkened where the baked horizon blocks the sky
+    float ambientStrength = 0.2 * Occlusion;
     vec3 ambient = ambientStrength * lightColor;
 
     // Diffuse
     vec3 norm = normalize(Normal);
-    vec3 lightDir = normalize(lightPos - FragPos);
+    // The shadow cascades are orthographic, so with shadows the light is
+    // treated as directional to keep diffuse and shadows consistent.
+    // Without shadows it stays a point light at lightPos.
+    vec3 lightDir = shadowsEnabled ? normalize(sunDirection) : normalize(lightPos - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
     vec3 diffuse = diff * lightColor;
 
@@ -29,6 +87,7 @@ void main()
     vec3 specular = specularStrength * spec * lightColor;
 
     // Combine
-    vec3 result = (ambient + diffuse + specular) * VertexColor;
+    float shadow = shadowFactor(norm, lightDir);
+    vec3 result = (ambient + shadow * (diffuse + specular)) * baseColor;
     FragColor = vec4(result, 1.0);
 }
@@ -3,20 +3,31 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec3 color;
+layout(location = 3) in float occlusion;  // baked AO, 1 = open sky
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec3 VertexColor;
+out float Height;
+out float ViewDepth;
+out float Occlusion;
 
-uniform mat4 model;
-uniform mat4 view;
+uniform mat4 model;          // world transform
+uniform mat4 modelRelative;  // model translated by -camera position
+uniform mat4 view;           // camera rotation only
 uniform mat4 projection;
 
 void main()
 {
-    FragPos = vec3(model * vec4(position, 1.0));
+    // Camera-relative from here on. The attribute itself is still an
+    // absolute world position, so this is not relative-to-eye precision;
+    // the terrain spans only `scale` units around the origin.
+    FragPos = vec3(modelRelative * vec4(position, 1.0));
     Normal = normalize(mat3(transpose(inverse(model))) * normal);
     VertexColor = color;
+    Occlusion = occlusion;
+    Height = (model * vec4(position, 1.0)).y;
+    ViewDepth = -(view * vec4(FragPos, 1.0)).z;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
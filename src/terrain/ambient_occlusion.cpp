@@ -0,0 +1,117 @@
+#include "ambient_occlusion.h"
+#include "../math/math.h"
+#include <algorithm>
+#include <cmath>
+
+AmbientOcclusionBaker::AmbientOcclusionBaker() : width(0), height(0), base(nullptr), stepCount(0) {}
+
+void AmbientOcclusionBaker::build(const std::vector<float>& heights, int w, int h, float cellSizeX, float cellSizeZ) {
+    width = w;
+    height = h;
+    base = heights.data();
+
+    pyramid.clear();
+    levelWidths.assign(1, w);
+    levelHeights.assign(1, h);
+
+    // Halve (rounding up) until one texel covers the grid
+    while (levelWidths.back() > 1 || levelHeights.back() > 1) {
+        int pw = levelWidths.back(), ph = levelHeights.back();
+        const float* previous = pyramid.empty() ? base : pyramid.back().data();
+        int lw = (pw + 1) / 2, lh = (ph + 1) / 2;
+
+        std::vector<float> level((size_t)lw * lh);
+        for (int z = 0; z < lh; z++) {
+            int z0 = z * 2, z1 = std::min(z0 + 1, ph - 1);
+            for (int x = 0; x < lw; x++) {
+                int x0 = x * 2, x1 = std::min(x0 + 1, pw - 1);
+                level[(size_t)z * lw + x] = std::max(
+                    std::max(previous[(size_t)z0 * pw + x0], previous[(size_t)z0 * pw + x1]),
+                    std::max(previous[(size_t)z1 * pw + x0], previous[(size_t)z1 * pw + x1]));
+            }
+        }
+        pyramid.push_back(std::move(level));
+        levelWidths.push_back(lw);
+        levelHeights.push_back(lh);
+    }
+
+    // Step offsets are the same for every grid point: one step at 1 cell,
+    // then d and 1.5d for d = 2, 4, ... from the level with d/2 blocks
+    std::vector<float> distances(1, 1.0f);
+    std::vector<int> levels(1, 0);
+    for (int level = 0; level + 1 < levelCount(); level++) {
+        float cells = (float)(2 << level);
+        distances.push_back(cells);
+        distances.push_back(cells * 1.5f);
+        levels.push_back(level);
+        levels.push_back(level);
+    }
+    stepCount = (int)distances.size();
+
+    steps.assign((size_t)stepCount * DIRECTIONS, Step());
+    for (int d = 0; d < DIRECTIONS; d++) {
+        float angle = 2.0f * PI * d / DIRECTIONS;
+        float dirX = std::cos(angle), dirZ = std::sin(angle);
+        for (int i = 0; i < stepCount; i++) {
+            int level = levels[i];
+            Step& step = steps[i * DIRECTIONS + d];
+            step.dx = (int)std::lround(dirX * distances[i]);
+            step.dz = (int)std::lround(dirZ * distances[i]);
+            step.shift = level;
+            step.stride = levelWidths[level];
+            step.data = level == 0 ? base : pyramid[level - 1].data();
+
+            // The block extends up to its width past the sample
+            float blockCells = (float)(1 << level);
+            float farX = (step.dx + dirX * blockCells) * cellSizeX;
+            float farZ = (step.dz + dirZ * blockCells) * cellSizeZ;
+            step.invDistance = 1.0f / std::sqrt(farX * farX + farZ * farZ);
+        }
+    }
+}
+
+void AmbientOcclusionBaker::bakeRows(int zBegin, int zEnd, unsigned char* occlusion) const {
+    for (int z = zBegin; z < zEnd; z++) {
+        for (int x = 0; x < width; x++) {
+            float h0 = base[(size_t)z * width + x];
+
+            // Steepest slope towards the horizon per direction. Steps are
+            // the outer loop so the directions form independent chains.
+            float slopes[DIRECTIONS] = {};
+            for (int i = 0; i < stepCount; i++) {
+                for (int d = 0; d < DIRECTIONS; d++) {
+                    const Step& step = steps[i * DIRECTIONS + d];
+                    int sx = x + step.dx;
+                    int sz = z + step.dz;
+                    // Steps only grow, so an outside sample stays outside
+                    if (sx < 0 || sx >= width || sz < 0 || sz >= height) continue;
+
+                    float maxHeight = step.data[(size_t)(sz >> step.shift) * step.stride + (sx >> step.shift)];
+                    slopes[d] = std::max(slopes[d], (maxHeight - h0) * step.invDistance);
+                }
+            }
+
+            // The horizon angle is monotonic in the slope: one sin() each
+            float sinSum = 0.0f;
+            for (int d = 0; d < DIRECTIONS; d++) {
+                sinSum += slopes[d] / std::sqrt(1.0f + slopes[d] * slopes[d]);
+            }
+
+            float visibility = 1.0f - sinSum / DIRECTIONS;
+            occlusion[(size_t)z * width + x] = (unsigned char)(visibility * 255.0f + 0.5f);
+        }
+    }
+}
+
+std::vector<unsigned char> AmbientOcclusionBaker::bake(JobSystem* jobs) const {
+    std::vector<unsigned char> occlusion((size_t)width * height, 255);
+    if (jobs) {
+        int rowsPerJob = std::max(1, height / (int)(jobs->workerCount() * 8));
+        jobs->wait(jobs->parallelFor(0, height, rowsPerJob, [this, &occlusion](int zBegin, int zEnd) {
+            bakeRows(zBegin, zEnd, occlusion.data());
+        }));
+    } else {
+        bakeRows(0, height, occlusion.data());
+    }
+    return occlusion;
+}
@@ -0,0 +1,55 @@
+#ifndef AMBIENT_OCCLUSION_H
+#define AMBIENT_OCCLUSION_H
+
+#include <vector>
+#include "../core/job_system.h"
+
+// Horizon-based ambient occlusion baked from a heightfield.
+//
+// build() makes a max-height pyramid: each level stores the highest
+// sample of a 2x2 block of the level below. For every grid point and
+// direction, the horizon is then found with two pyramid lookups per
+// doubling of distance d (at d and 1.5d), each from the level whose
+// blocks are d/2 wide. That is O(log n) lookups per direction instead of
+// a full ray march. The block maximum can sit anywhere in its block, so
+// its slope is taken at the block's far edge (offset plus block size);
+// against a brute-force march that stays within a few percent, where one
+// full-width block at the step distance was twice too steep.
+//
+// Occlusion is 1 - mean(sin(horizon elevation)) over DIRECTIONS, stored
+// as one byte per grid point (255 = open sky).
+class AmbientOcclusionBaker {
+public:
+    static const int DIRECTIONS = 8;
+
+    AmbientOcclusionBaker();
+
+    // heights must stay alive and unchanged until baking is done
+    void build(const std::vector<float>& heights, int width, int height, float cellSizeX, float cellSizeZ);
+
+    // Bakes rows [zBegin, zEnd) into occlusion, which spans the full grid
+    void bakeRows(int zBegin, int zEnd, unsigned char* occlusion) const;
+
+    // Whole grid, split across the job system when one is given
+    std::vector<unsigned char> bake(JobSystem* jobs = nullptr) const;
+
+    int levelCount() const { return (int)levelWidths.size(); }
+
+private:
+    struct Step {
+        int dx, dz;
+        int shift;          // pyramid level: grid coordinate >> shift
+        int stride;         // row length of that level
+        const float* data;
+        float invDistance;  // 1 / world distance of the block's far edge
+    };
+
+    int width, height;
+    const float* base;                    // level 0 is the source grid
+    std::vector<std::vector<float>> pyramid; // levels 1..n
+    std::vector<int> levelWidths, levelHeights;
+    std::vector<Step> steps;              // [step * DIRECTIONS + direction]
+    int stepCount;
+};
+
+#endif // AMBIENT_OCCLUSION_H
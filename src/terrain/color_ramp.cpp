@@ -0,0 +1,110 @@
+#include "color_ramp.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+ColorRamp::ColorRamp() : lut(LUT_SIZE * 3, 0.0f) {
+    // Deep water, shallow water, sand, grass, forest, snow
+    setStops({
+        { 0.0f,  Vector3(0.1f, 0.2f, 0.4f) },
+        { 0.3f,  Vector3(0.3f, 0.5f, 0.7f) },
+        { 0.45f, Vector3(0.7f, 0.8f, 0.4f) },
+        { 0.7f,  Vector3(0.3f, 0.95f, 0.2f) },
+        { 0.85f, Vector3(0.2f, 0.65f, 0.3f) },
+        { 0.85f, Vector3(0.8f, 0.8f, 0.8f) },
+        { 1.0f,  Vector3(1.0f, 1.0f, 1.0f) }
+    });
+}
+
+bool ColorRamp::loadFromFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "ERROR: Failed to read color ramp: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<Stop> loaded;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        std::istringstream fields(line);
+        Stop stop;
+        if (!(fields >> stop.position >> stop.color.x >> stop.color.y >> stop.color.z)) {
+            std::cerr << "ERROR: Malformed color stop at " << path << ":" << lineNumber << std::endl;
+            return false;
+        }
+        loaded.push_back(stop);
+    }
+
+    if (loaded.size() < 2) {
+        std::cerr << "ERROR: Color ramp needs at least two stops: " << path << std::endl;
+        return false;
+    }
+
+    setStops(loaded);
+    return true;
+}
+
+void ColorRamp::setStops(const std::vector<Stop>& newStops) {
+    stops = newStops;
+    for (Stop& stop : stops) {
+        stop.position = std::max(0.0f, std::min(1.0f, stop.position));
+    }
+    // Stable so coincident stops keep their order (hard edges)
+    std::stable_sort(stops.begin(), stops.end(),
+                     [](const Stop& a, const Stop& b) { return a.position < b.position; });
+    bake();
+}
+
+void ColorRamp::bake() {
+    size_t next = 0;
+    for (int i = 0; i < LUT_SIZE; i++) {
+        float t = (float)i / (LUT_SIZE - 1);
+
+        // Last stop at or before t; coincident stops resolve to the later one
+        while (next + 1 < stops.size() && stops[next + 1].position <= t) next++;
+
+        Vector3 color = stops[next].color;
+        if (next + 1 < stops.size() && t > stops[next].position) {
+            const Stop& a = stops[next];
+            const Stop& b = stops[next + 1];
+            color = Vector3::lerp(a.color, b.color, (t - a.position) / (b.position - a.position));
+        } else if (t < stops[next].position) {
+            color = stops[0].color;
+        }
+
+        lut[i * 3 + 0] = color.x;
+        lut[i * 3 + 1] = color.y;
+        lut[i * 3 + 2] = color.z;
+    }
+}
+
+Vector3 ColorRamp::sample(float normalized) const {
+    Vector3 color;
+    evaluate(&normalized, 1, 1.0f, &color.x);
+    return color;
+}
+
+void ColorRamp::evaluate(const float* heights, size_t count, float invHeightScale,
+                         float* rgb, size_t strideFloats) const {
+    const float* table = lut.data();
+    const float maxIndex = (float)(LUT_SIZE - 1);
+
+    // Branch-free: clamp, split into entry + fraction, lerp two entries
+    for (size_t i = 0; i < count; i++) {
+        float f = std::max(0.0f, std::min(1.0f, heights[i] * invHeightScale)) * maxIndex;
+        int index = std::min((int)f, LUT_SIZE - 2);
+        float t = f - (float)index;
+
+        const float* a = table + index * 3;
+        float* out = rgb + i * strideFloats;
+        out[0] = a[0] + (a[3] - a[0]) * t;
+        out[1] = a[1] + (a[4] - a[1]) * t;
+        out[2] = a[2] + (a[5] - a[2]) * t;
+    }
+}
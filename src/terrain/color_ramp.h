@@ -0,0 +1,46 @@
+#ifndef COLOR_RAMP_H
+#define COLOR_RAMP_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "../math/math.h"
+
+// Height-to-color gradient baked into a fixed-size lookup table.
+// Stops are given over normalized height [0, 1]; two stops at the same
+// position produce a hard edge.
+class ColorRamp {
+public:
+    static const int LUT_SIZE = 256;
+
+    struct Stop {
+        float position;
+        Vector3 color;
+    };
+
+    ColorRamp();
+
+    // Text format, one stop per line: "position r g b", '#' starts a comment
+    bool loadFromFile(const std::string& path);
+    void setStops(const std::vector<Stop>& stops);
+    const std::vector<Stop>& getStops() const { return stops; }
+
+    // Single lookup, normalized height
+    Vector3 sample(float normalized) const;
+
+    // Batch lookup over a height array. Colors are written as RGB floats
+    // starting at rgb, advancing strideFloats per element.
+    void evaluate(const float* heights, size_t count, float invHeightScale,
+                  float* rgb, size_t strideFloats = 3) const;
+
+    // LUT_SIZE interleaved RGB entries, e.g. for a 1D texture
+    const float* lutData() const { return lut.data(); }
+
+private:
+    std::vector<Stop> stops;
+    std::vector<float> lut;
+
+    void bake();
+};
+
+#endif // COLOR_RAMP_H
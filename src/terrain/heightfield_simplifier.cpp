@@ -0,0 +1,172 @@
+#include "heightfield_simplifier.h"
+#include <algorithm>
+#include <cmath>
+
+// Error of splits that must happen regardless of maxError
+static const float FORCED_SPLIT = 1e30f;
+
+HeightfieldSimplifier::HeightfieldSimplifier(const std::vector<float>& heights, int width, int height, int tiles)
+    : sourceWidth(width), sourceHeight(height), tileSize(tiles), size(2) {
+    while (size - 1 < std::max(width, height) - 1) {
+        size = (size - 1) * 2 + 1;
+    }
+    pad(heights);
+    computeErrors();
+}
+
+void HeightfieldSimplifier::pad(const std::vector<float>& heights) {
+    grid.resize((size_t)size * size);
+
+    // Samples past the source edge repeat the edge; no triangle that uses
+    // them is ever emitted
+    for (int z = 0; z < size; z++) {
+        const float* row = &heights[(size_t)std::min(z, sourceHeight - 1) * sourceWidth];
+        for (int x = 0; x < size; x++) {
+            grid[(size_t)z * size + x] = row[std::min(x, sourceWidth - 1)];
+        }
+    }
+}
+
+bool HeightfieldSimplifier::isOutside(int ax, int ay, int bx, int by, int cx, int cy) const {
+    int minX = std::min(ax, std::min(bx, cx));
+    int minY = std::min(ay, std::min(by, cy));
+    return minX >= sourceWidth - 1 || minY >= sourceHeight - 1;
+}
+
+bool HeightfieldSimplifier::mustSplit(int ax, int ay, int bx, int by, int cx, int cy) const {
+    int minX = std::min(ax, std::min(bx, cx)), maxX = std::max(ax, std::max(bx, cx));
+    int minY = std::min(ay, std::min(by, cy)), maxY = std::max(ay, std::max(by, cy));
+
+    // Straddles the source edge
+    const int edgeX = sourceWidth - 1, edgeY = sourceHeight - 1;
+    if ((minX < edgeX && maxX > edgeX) || (minY < edgeY && maxY > edgeY)) return true;
+    if (tileSize <= 0) return false;
+
+    // Straddles a tile boundary
+    if ((minX / tileSize + 1) * tileSize < maxX) return true;
+    if ((minY / tileSize + 1) * tileSize < maxY) return true;
+
+    // Has an edge longer than one cell lying on an interior tile boundary
+    const int xs[3] = { ax, bx, cx }, ys[3] = { ay, by, cy };
+    for (int e = 0; e < 3; e++) {
+        int x0 = xs[e], y0 = ys[e];
+        int x1 = xs[(e + 1) % 3], y1 = ys[(e + 1) % 3];
+        if (x0 == x1 && x0 % tileSize == 0 && x0 > 0 && x0 < edgeX && std::abs(y1 - y0) > 1) return true;
+        if (y0 == y1 && y0 % tileSize == 0 && y0 > 0 && y0 < edgeY && std::abs(x1 - x0) > 1) return true;
+    }
+    return false;
+}
+
+void HeightfieldSimplifier::computeErrors() {
+    const int gridCells = size - 1;
+    const long long numTriangles = (long long)gridCells * gridCells * 2 - 2;
+    const long long numParentTriangles = numTriangles - (long long)gridCells * gridCells;
+
+    errors.assign((size_t)size * size, 0.0f);
+
+    // Children are visited before parents. Replacing the two children by
+    // their parent moves the surface by at most the midpoint error, so the
+    // parent's bound is that error plus the worst child bound.
+    for (long long i = numTriangles - 1; i >= 0; i--) {
+        // Decode the triangle's hypotenuse (a, b) from its implicit binary tree id
+        long long id = i + 2;
+        int ax = 0, ay = 0, bx = 0, by = 0, cx = 0, cy = 0;
+        if (id & 1) {
+            bx = by = cx = gridCells;
+        } else {
+            ax = ay = cy = gridCells;
+        }
+        while ((id >>= 1) > 1) {
+            int mx = (ax + bx) >> 1;
+            int my = (ay + by) >> 1;
+            if (id & 1) {
+                bx = ax; by = ay;
+                ax = cx; ay = cy;
+            } else {
+                ax = bx; ay = by;
+                bx = cx; by = cy;
+            }
+            cx = mx; cy = my;
+        }
+
+        // Padding never contributes error
+        if (isOutside(ax, ay, bx, by, cx, cy)) continue;
+
+        int mx = (ax + bx) >> 1;
+        int my = (ay + by) >> 1;
+        size_t middle = (size_t)my * size + mx;
+
+        float middleError;
+        if (mustSplit(ax, ay, bx, by, cx, cy)) {
+            middleError = FORCED_SPLIT;
+        } else {
+            float interpolated = (grid[(size_t)ay * size + ax] + grid[(size_t)by * size + bx]) * 0.5f;
+            middleError = std::fabs(interpolated - grid[middle]);
+        }
+
+        if (i < numParentTriangles) {
+            size_t left = (size_t)((ay + cy) >> 1) * size + ((ax + cx) >> 1);
+            size_t right = (size_t)((by + cy) >> 1) * size + ((bx + cx) >> 1);
+            middleError += std::max(errors[left], errors[right]);
+        }
+
+        // The midpoint is shared with the triangle across the hypotenuse
+        errors[middle] = std::max(errors[middle], middleError);
+    }
+}
+
+HeightfieldSimplifier::Result HeightfieldSimplifier::extract(float maxError) const {
+    Result result;
+    result.sourceTriangles = (size_t)(sourceWidth - 1) * (sourceHeight - 1) * 2;
+
+    const int gridCells = size - 1;
+    std::vector<unsigned int> vertexIds((size_t)size * size, 0);
+
+    auto vertexId = [&](int x, int z) {
+        unsigned int& id = vertexIds[(size_t)z * size + x];
+        if (id == 0) {
+            result.gridX.push_back((float)x);
+            result.gridZ.push_back((float)z);
+            result.heights.push_back(grid[(size_t)z * size + x]);
+            id = (unsigned int)result.heights.size();
+        }
+        return id - 1;
+    };
+
+    // Explicit stack instead of recursion; deep grids split up to 2 * log2(size) times
+    struct Triangle { int ax, ay, bx, by, cx, cy; };
+    std::vector<Triangle> stack = {
+        { 0, 0, gridCells, gridCells, gridCells, 0 },
+        { gridCells, gridCells, 0, 0, 0, gridCells }
+    };
+
+    while (!stack.empty()) {
+        Triangle t = stack.back();
+        stack.pop_back();
+        if (isOutside(t.ax, t.ay, t.bx, t.by, t.cx, t.cy)) continue;
+
+        int mx = (t.ax + t.bx) >> 1;
+        int my = (t.ay + t.by) >> 1;
+        bool canSplit = std::abs(t.ax - t.cx) + std::abs(t.ay - t.cy) > 1;
+
+        if (canSplit && errors[(size_t)my * size + mx] > maxError) {
+            stack.push_back({ t.bx, t.by, t.cx, t.cy, mx, my });
+            stack.push_back({ t.cx, t.cy, t.ax, t.ay, mx, my });
+            continue;
+        }
+
+        unsigned int a = vertexId(t.ax, t.ay);
+        unsigned int b = vertexId(t.bx, t.by);
+        unsigned int c = vertexId(t.cx, t.cy);
+
+        // Match the winding of Terrain::generateIndices() (up-facing)
+        long long cross = (long long)(t.bx - t.ax) * (t.cy - t.ay) - (long long)(t.by - t.ay) * (t.cx - t.ax);
+        if (cross > 0) std::swap(b, c);
+
+        result.indices.push_back(a);
+        result.indices.push_back(b);
+        result.indices.push_back(c);
+    }
+
+    return result;
+}
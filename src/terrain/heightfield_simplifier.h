@@ -0,0 +1,55 @@
+#ifndef HEIGHTFIELD_SIMPLIFIER_H
+#define HEIGHTFIELD_SIMPLIFIER_H
+
+#include <vector>
+#include <cstddef>
+
+// Adaptive triangulation of a heightfield using a right-triangulated
+// irregular network (RTIN). The error of every split is computed once in
+// a bottom-up pass; extract() then refines only where the vertical error
+// exceeds the requested bound, producing a crack-free mesh.
+//
+// Grids that are not (2^k + 1) squared are padded to the next such size
+// by clamping the edge samples. Triangles crossing the source edge are
+// always split and those outside it are dropped, so the output uses only
+// source samples and never has more triangles than the full grid.
+//
+// With a tile size, no triangle crosses a tile boundary and edges along
+// the boundaries stay at full resolution, so each tile can be swapped
+// for the full grid's tile without cracks.
+class HeightfieldSimplifier {
+public:
+    struct Result {
+        std::vector<float> gridX;  // vertex x on the source grid [0, width - 1]
+        std::vector<float> gridZ;  // vertex z on the source grid [0, height - 1]
+        std::vector<float> heights;
+        std::vector<unsigned int> indices;
+        size_t sourceTriangles = 0;
+
+        size_t triangleCount() const { return indices.size() / 3; }
+        float reductionRatio() const {
+            return sourceTriangles ? (float)triangleCount() / (float)sourceTriangles : 1.0f;
+        }
+    };
+
+    // tileSize in cells; 0 for no tile constraints
+    HeightfieldSimplifier(const std::vector<float>& heights, int width, int height, int tileSize = 0);
+
+    Result extract(float maxError) const;
+
+    int gridSize() const { return size; }
+
+private:
+    int sourceWidth, sourceHeight;
+    int tileSize;
+    int size;
+    std::vector<float> grid;
+    std::vector<float> errors;
+
+    void pad(const std::vector<float>& heights);
+    bool isOutside(int ax, int ay, int bx, int by, int cx, int cy) const;
+    bool mustSplit(int ax, int ay, int bx, int by, int cx, int cy) const;
+    void computeErrors();
+};
+
+#endif // HEIGHTFIELD_SIMPLIFIER_H
@@ -88,6 +88,19 @@ float PerlinNoise::noise(float x, float y, float z) const {
 }
 
 float PerlinNoise::fbm(float x, float y, float z, int octaves, float persistence, float lacunarity) const {
+    if (persistence == 0.5f && lacunarity == 2.0f) {
+        switch (octaves) {
+            case 4: return fbmFixed<4>(x, y, z);
+            case 5: return fbmFixed<5>(x, y, z);
+            case 6: return fbmFixed<6>(x, y, z);
+            case 8: return fbmFixed<8>(x, y, z);
+            default: break;
+        }
+    }
+    return fbmGeneric(x, y, z, octaves, persistence, lacunarity);
+}
+
+float PerlinNoise::fbmGeneric(float x, float y, float z, int octaves, float persistence, float lacunarity) const {
     float result = 0.0f;
     float amplitude = 1.0f;
     float frequency = 1.0f;
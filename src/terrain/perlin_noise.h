@@ -1,19 +1,81 @@
 #ifndef PERLIN_NOISE_H
 #define PERLIN_NOISE_H
 
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+// Noise basis functions usable as fBm octaves
+struct PerlinBasis {
+    template <typename Noise>
+    static float sample(const Noise& n, float x, float y, float z) {
+        return n.noise(x, y, z);
+    }
+};
+
+struct RidgedBasis {
+    template <typename Noise>
+    static float sample(const Noise& n, float x, float y, float z) {
+        return 1.0f - std::fabs(n.noise(x, y, z) * 2.0f - 1.0f);
+    }
+};
+
 class PerlinNoise {
 public:
+    PerlinNoise();
+    explicit PerlinNoise(unsigned int seed);
+
     // Fade function
-    static float fade(float t);
+    float fade(float t) const;
 
     // Linear interpolation function
-    static float lerp(float a, float b, float t);
-    
+    float lerp(float t, float a, float b) const;
+
     // Gradient function
-    static float grad(int hash, float x, float y, float z);
-    
-    // Fractal Brownian Motion method
-    static float fbm(float x, float y, float z, int octaves);
+    float grad(int hash, float x, float y, float z) const;
+
+    // 3D Perlin noise in [0, 1]
+    float noise(float x, float y, float z) const;
+
+    // Fractal Brownian Motion method. Common configurations are dispatched
+    // to the specialized kernels below, everything else takes the generic loop.
+    float fbm(float x, float y, float z, int octaves, float persistence = 0.5f, float lacunarity = 2.0f) const;
+
+    // Generic runtime fBm loop
+    float fbmGeneric(float x, float y, float z, int octaves, float persistence, float lacunarity) const;
+
+    // fBm specialized on octave count and basis, with persistence 0.5 and
+    // lacunarity 2.0 folded in. The octave loop is unrolled at compile time
+    // and the normalization factor is a constant.
+    template <int Octaves, typename Basis = PerlinBasis>
+    float fbmFixed(float x, float y, float z) const {
+        static_assert(Octaves > 0 && Octaves <= 16, "unsupported octave count");
+        constexpr float norm = fbmNormalization(Octaves);
+        return fbmOctaves<Basis>(x, y, z, std::make_integer_sequence<int, Octaves>()) * norm;
+    }
+
+private:
+    std::vector<int> permutation;
+    std::vector<int> p;
+
+    // 1 / (1 + 0.5 + 0.25 + ...) for the given octave count
+    static constexpr float fbmNormalization(int octaves) {
+        float maxValue = 0.0f;
+        float amplitude = 1.0f;
+        for (int i = 0; i < octaves; i++) {
+            maxValue += amplitude;
+            amplitude *= 0.5f;
+        }
+        return 1.0f / maxValue;
+    }
+
+    // Octave I samples at frequency 2^I with amplitude 2^-I
+    template <typename Basis, int... I>
+    float fbmOctaves(float x, float y, float z, std::integer_sequence<int, I...>) const {
+        return (0.0f + ... + (Basis::sample(*this, x * float(1 << I), y * float(1 << I), z * float(1 << I))
+                              * (1.0f / float(1 << I))));
+    }
 };
 
 #endif // PERLIN_NOISE_H
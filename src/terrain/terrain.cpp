@@ -1,67 +1,362 @@
 #include "terrain.h"
+#include "heightfield_simplifier.h"
+#include "../graphics/mesh_optimizer.h"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <memory>
 
 Terrain::Terrain(int width, int height, float scale, float heightScale)
-    : width(width), height(height), scale(scale), heightScale(heightScale),
-      noiseGenerator(12345) {
+    : lodMaxError(0.5f), lodDistance(scale * 0.5f), lodTileSize(64),
+      width(width), height(height), scale(scale), heightScale(heightScale), patchSize(16),
+      gpuColors(false), noiseGenerator(12345), tilesPublished(false) {
 }
 
-void Terrain::generate() {
-    mesh.vertices.clear();
+void Terrain::generate(JobSystem& jobs) {
+    prepareBuffers();
+    sampleHeights(0, height);
+    computePatchBounds();
+    bakeOcclusion(jobs);
+    generateIndices();
+    calculateNormals();
+    optimizeLayout();
+    applyOcclusion(mesh);
+    mesh.setupMesh();
+    logStats();
+
+    buildLodMesh();
+    applyOcclusion(lodMesh);
+    lodMesh.setupMesh();
+    tilesPublished.store(true, std::memory_order_release);
+}
+
+JobHandle Terrain::generateAsync(JobSystem& jobs, UploadQueue& uploads) {
+    prepareBuffers();
+
+    // Noise rows and index building are independent; normals need both
+    int rowsPerJob = std::max(1, height / (int)(jobs.workerCount() * 4));
+    JobHandle heights = jobs.parallelFor(0, height, rowsPerJob, [this](int zBegin, int zEnd) {
+        sampleHeights(zBegin, zEnd);
+    });
+    JobHandle indices = jobs.schedule([this]() { generateIndices(); });
+    JobHandle normals = jobs.schedule([this]() {
+        calculateNormals();
+        optimizeLayout();
+    }, { heights, indices });
+    JobHandle lod = jobs.schedule([this]() { buildLodMesh(); }, { heights });
+    JobHandle bounds = jobs.schedule([this]() { computePatchBounds(); }, { heights });
+
+    // Occlusion: the pyramid is built once, then rows bake in parallel
+    auto baker = std::make_shared<AmbientOcclusionBaker>();
+    auto bakeStart = std::make_shared<std::chrono::steady_clock::time_point>();
+    JobHandle pyramid = jobs.schedule([this, baker, bakeStart]() {
+        *bakeStart = std::chrono::steady_clock::now();
+        baker->build(heightMap, width, height, scale / (width - 1), scale / (height - 1));
+    }, { heights });
+    JobHandle occlusionRows = jobs.parallelFor(0, height, rowsPerJob, [this, baker](int zBegin, int zEnd) {
+        baker->bakeRows(zBegin, zEnd, occlusionMap.data());
+    }, { pyramid });
+    JobHandle occlusion = jobs.schedule([this, bakeStart]() {
+        logOcclusion(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - *bakeStart).count());
+    }, { occlusionRows });
+
+    return jobs.schedule([this, &uploads]() {
+        applyOcclusion(mesh);
+        applyOcclusion(lodMesh);
+        logStats();
+
+        // Index and LOD jobs are done with the tile ranges
+        tilesPublished.store(true, std::memory_order_release);
+        uploads.push(&mesh);
+        uploads.push(&lodMesh);
+    }, { normals, lod, bounds, occlusion });
+}
+
+void Terrain::prepareBuffers() {
+    tilesPublished.store(false, std::memory_order_relaxed);
+    mesh.cleanup();
+    lodMesh.cleanup();
+    mesh.includeColor = !gpuColors;
+    lodMesh.includeColor = !gpuColors;
+    mesh.vertices.assign((size_t)width * height, Vertex());
     mesh.indices.clear();
+    heightMap.assign((size_t)width * height, 0.0f);
+    occlusionMap.assign((size_t)width * height, 255);
+    patchBounds.clear();
 
-    // Generate vertices
-    for (int z = 0; z < height; z++) {
+    // Sized up front: the index and LOD jobs fill in different fields
+    int tilesX = (width - 2) / lodTileSize + 1;
+    int tilesZ = (height - 2) / lodTileSize + 1;
+    tiles.assign((size_t)tilesX * tilesZ, Tile());
+    for (int tz = 0; tz < tilesZ; tz++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            Tile& tile = tiles[(size_t)tz * tilesX + tx];
+            tile.minX = (float)(tx * lodTileSize) / (width - 1) * scale - scale / 2;
+            tile.maxX = (float)std::min((tx + 1) * lodTileSize, width - 1) / (width - 1) * scale - scale / 2;
+            tile.minZ = (float)(tz * lodTileSize) / (height - 1) * scale - scale / 2;
+            tile.maxZ = (float)std::min((tz + 1) * lodTileSize, height - 1) / (height - 1) * scale - scale / 2;
+        }
+    }
+}
+
+void Terrain::sampleRow(int z, float* heights) const {
+    float zCoord = (float)z / (height - 1) * scale;
+    for (int x = 0; x < width; x++) {
+        float xCoord = (float)x / (width - 1) * scale;
+
+        // Use Perlin noise for height
+        float noiseVal = noiseGenerator.fbm(xCoord * 0.8f, zCoord * 0.8f, 0.0f, 6, 0.5f, 2.0f);
+        heights[x] = noiseVal * heightScale;
+    }
+}
+
+void Terrain::sampleHeights(int zBegin, int zEnd) {
+    for (int z = zBegin; z < zEnd; z++) {
+        float* row = &heightMap[(size_t)z * width];
+        Vertex* rowVertices = &mesh.vertices[(size_t)z * width];
+        sampleRow(z, row);
+
+        float zCoord = (float)z / (height - 1) * scale;
         for (int x = 0; x < width; x++) {
             float xCoord = (float)x / (width - 1) * scale;
-            float zCoord = (float)z / (height - 1) * scale;
+            rowVertices[x].position = Vector3(xCoord - scale / 2, row[x], zCoord - scale / 2);
+            rowVertices[x].normal = Vector3(0, 1, 0); // Will be calculated later
+        }
+
+        // Colors for the whole row in one pass over the ramp
+        if (!gpuColors) {
+            colorRamp.evaluate(row, width, 1.0f / heightScale, &rowVertices[0].color.x,
+                               sizeof(Vertex) / sizeof(float));
+        }
+    }
+}
+
+void Terrain::logStats() const {
+    std::cout << "Terrain generated with " << mesh.vertices.size() << " vertices and "
+              << mesh.indices.size() << " indices (ACMR "
+              << MeshOptimizer::computeACMR(mesh.indices, mesh.vertices.size()) << ")" << std::endl;
+}
 
-            // Use Perlin noise for height
-            float noiseVal = noiseGenerator.fbm(xCoord * 0.8f, zCoord * 0.8f, 0.0f, 6, 0.5f, 2.0f);
-            float y = noiseVal * heightScale;
+void Terrain::computePatchBounds() {
+    // Patches share their border samples so the boxes tile without gaps
+    int cells = std::max(1, patchSize);
+    int patchesX = (width - 2) / cells + 1;
+    int patchesZ = (height - 2) / cells + 1;
+    patchBounds.assign((size_t)patchesX * patchesZ, BoundingBox());
 
-            Vector3 pos(xCoord - scale / 2, y, zCoord - scale / 2);
-            Vector3 color = getColorByHeight(y);
+    for (int pz = 0; pz < patchesZ; pz++) {
+        int z0 = pz * cells;
+        int z1 = std::min(z0 + cells, height - 1);
+        for (int px = 0; px < patchesX; px++) {
+            int x0 = px * cells;
+            int x1 = std::min(x0 + cells, width - 1);
 
-            Vertex v;
-            v.position = pos;
-            v.color = color;
-            v.normal = Vector3(0, 1, 0); // Will be calculated later
+            float minY = heightMap[(size_t)z0 * width + x0];
+            float maxY = minY;
+            for (int z = z0; z <= z1; z++) {
+                const float* row = &heightMap[(size_t)z * width];
+                for (int x = x0; x <= x1; x++) {
+                    minY = std::min(minY, row[x]);
+                    maxY = std::max(maxY, row[x]);
+                }
+            }
 
-            mesh.vertices.push_back(v);
+            BoundingBox& box = patchBounds[(size_t)pz * patchesX + px];
+            box.min = Vector3((float)x0 / (width - 1) * scale - scale / 2, minY,
+                              (float)z0 / (height - 1) * scale - scale / 2);
+            box.max = Vector3((float)x1 / (width - 1) * scale - scale / 2, maxY,
+                              (float)z1 / (height - 1) * scale - scale / 2);
         }
     }
+}
 
-    generateIndices();
-    calculateNormals();
-    mesh.setupMesh();
+void Terrain::bakeOcclusion(JobSystem& jobs) {
+    auto start = std::chrono::steady_clock::now();
+    AmbientOcclusionBaker baker;
+    baker.build(heightMap, width, height, scale / (width - 1), scale / (height - 1));
+    occlusionMap = baker.bake(&jobs);
+    logOcclusion(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
 
-    std::cout << "Terrain generated with " << mesh.vertices.size() << " vertices and "
-              << mesh.indices.size() << " indices" << std::endl;
+void Terrain::logOcclusion(double milliseconds) const {
+    std::cout << "Ambient occlusion baked for " << width << "x" << height << " grid in " << milliseconds
+              << " ms (" << milliseconds * 1.0e6 / ((double)width * height) << " ns/sample)" << std::endl;
+}
+
+void Terrain::applyOcclusion(Mesh& target) const {
+    // Vertices may be reordered or off-grid (LOD), so look up by position
+    const float toGridX = (width - 1) / scale;
+    const float toGridZ = (height - 1) / scale;
+    target.occlusion.resize(target.vertices.size());
+
+    for (size_t i = 0; i < target.vertices.size(); i++) {
+        const Vector3& p = target.vertices[i].position;
+        float gx = std::min(std::max((p.x + scale / 2) * toGridX, 0.0f), (float)(width - 1));
+        float gz = std::min(std::max((p.z + scale / 2) * toGridZ, 0.0f), (float)(height - 1));
+        int x0 = std::min((int)gx, width - 2);
+        int z0 = std::min((int)gz, height - 2);
+        float tx = gx - x0, tz = gz - z0;
+
+        const unsigned char* row0 = &occlusionMap[(size_t)z0 * width];
+        const unsigned char* row1 = row0 + width;
+        float a = row0[x0] + (row0[x0 + 1] - row0[x0]) * tx;
+        float b = row1[x0] + (row1[x0 + 1] - row1[x0]) * tx;
+        target.occlusion[i] = (unsigned char)(a + (b - a) * tz + 0.5f);
+    }
+}
+
+void Terrain::buildLodMesh() {
+    HeightfieldSimplifier simplifier(heightMap, width, height, lodTileSize);
+    HeightfieldSimplifier::Result result = simplifier.extract(lodMaxError);
+
+    std::cout << "LOD mesh: " << result.triangleCount() << " of " << result.sourceTriangles
+              << " triangles (" << result.reductionRatio() * 100.0f << "%) at max error "
+              << lodMaxError << std::endl;
+
+    // Rough terrain may not simplify at all; then the full mesh is used everywhere
+    if (result.reductionRatio() >= 1.0f) {
+        std::cout << "LOD mesh saves no triangles, using the full mesh" << std::endl;
+        return;
+    }
+
+    lodMesh.vertices.resize(result.heights.size());
+    for (size_t i = 0; i < result.heights.size(); i++) {
+        float xCoord = result.gridX[i] / (width - 1) * scale;
+        float zCoord = result.gridZ[i] / (height - 1) * scale;
+
+        Vertex& v = lodMesh.vertices[i];
+        v.position = Vector3(xCoord - scale / 2, result.heights[i], zCoord - scale / 2);
+        v.color = getColorByHeight(result.heights[i]);
+        v.normal = sampleNormal(result.gridX[i], result.gridZ[i]);
+    }
+
+    // No triangle crosses a tile edge, so each one belongs to the tile of its centroid
+    const int tilesX = (width - 2) / lodTileSize + 1;
+    std::vector<std::vector<unsigned int>> tileIndices(tiles.size());
+    for (size_t i = 0; i < result.indices.size(); i += 3) {
+        const unsigned int* tri = &result.indices[i];
+        float cx = (result.gridX[tri[0]] + result.gridX[tri[1]] + result.gridX[tri[2]]) / 3.0f;
+        float cz = (result.gridZ[tri[0]] + result.gridZ[tri[1]] + result.gridZ[tri[2]]) / 3.0f;
+        size_t t = (size_t)((int)cz / lodTileSize) * tilesX + (int)cx / lodTileSize;
+        tileIndices[t].insert(tileIndices[t].end(), tri, tri + 3);
+    }
+
+    // RTIN output follows the split tree, so reorder each tile for the
+    // vertex cache, on tile-local vertex ids to keep the work per tile small
+    lodMesh.indices.clear();
+    lodMesh.indices.reserve(result.indices.size());
+    std::vector<unsigned int> localIds(lodMesh.vertices.size(), ~0u);
+    std::vector<unsigned int> globalIds;
+    for (size_t t = 0; t < tiles.size(); t++) {
+        std::vector<unsigned int>& local = tileIndices[t];
+        globalIds.clear();
+        for (unsigned int& index : local) {
+            if (localIds[index] == ~0u) {
+                localIds[index] = (unsigned int)globalIds.size();
+                globalIds.push_back(index);
+            }
+            index = localIds[index];
+        }
+        MeshOptimizer::optimizeVertexCache(local, globalIds.size());
+
+        tiles[t].lodFirst = (unsigned int)lodMesh.indices.size();
+        tiles[t].lodCount = (unsigned int)local.size();
+        for (unsigned int index : local) {
+            lodMesh.indices.push_back(globalIds[index]);
+        }
+        for (unsigned int id : globalIds) {
+            localIds[id] = ~0u;
+        }
+    }
+    MeshOptimizer::optimizeVertexFetch(lodMesh.vertices, lodMesh.indices);
+}
+
+void Terrain::draw(const Vector3& viewPos) const {
+    if (!tilesReady()) return;
+    bool lodReady = lodMesh.isReady();
+    for (const Tile& tile : tiles) {
+        // Horizontal distance to the tile's footprint
+        float dx = std::max(std::max(tile.minX - viewPos.x, viewPos.x - tile.maxX), 0.0f);
+        float dz = std::max(std::max(tile.minZ - viewPos.z, viewPos.z - tile.maxZ), 0.0f);
+        bool distant = dx * dx + dz * dz > lodDistance * lodDistance;
+
+        // Far away the adaptive tile is indistinguishable from the full grid
+        if (distant && lodReady && tile.lodCount < tile.fullCount) {
+            lodMesh.drawRange(tile.lodFirst, tile.lodCount);
+        } else {
+            mesh.drawRange(tile.fullFirst, tile.fullCount);
+        }
+    }
+}
+
+Vector3 Terrain::sampleNormal(float gridX, float gridZ) const {
+    // Central differences of the height map, bilinearly weighted
+    auto heightAt = [this](int x, int z) {
+        x = std::max(0, std::min(width - 1, x));
+        z = std::max(0, std::min(height - 1, z));
+        return heightMap[(size_t)z * width + x];
+    };
+    auto gradientAt = [&](int x, int z) {
+        return Vector3(heightAt(x - 1, z) - heightAt(x + 1, z), 0.0f, heightAt(x, z - 1) - heightAt(x, z + 1));
+    };
+
+    int x0 = (int)gridX;
+    int z0 = (int)gridZ;
+    float tx = gridX - x0;
+    float tz = gridZ - z0;
+    Vector3 g = Vector3::lerp(Vector3::lerp(gradientAt(x0, z0), gradientAt(x0 + 1, z0), tx),
+                              Vector3::lerp(gradientAt(x0, z0 + 1), gradientAt(x0 + 1, z0 + 1), tx), tz);
+
+    float cellX = scale / (width - 1);
+    float cellZ = scale / (height - 1);
+    return Vector3(g.x * cellZ, 2.0f * cellX * cellZ, g.z * cellX).normalized();
 }
 
 void Terrain::generateIndices() {
-    for (int z = 0; z < height - 1; z++) {
-        for (int x = 0; x < width - 1; x++) {
-            int a = z * width + x;
-            int b = z * width + (x + 1);
-            int c = (z + 1) * width + x;
-            int d = (z + 1) * width + (x + 1);
-
-            // First triangle
-            mesh.indices.push_back(a);
-            mesh.indices.push_back(c);
-            mesh.indices.push_back(b);
-
-            // Second triangle
-            mesh.indices.push_back(b);
-            mesh.indices.push_back(c);
-            mesh.indices.push_back(d);
+    mesh.indices.reserve((size_t)(width - 1) * (height - 1) * 6);
+
+    // Walk each tile in vertical strips narrow enough that the previous
+    // row of the strip is still in the post-transform cache (row-by-row
+    // order over a wide grid misses on nearly every vertex)
+    const int stripCells = MeshOptimizer::DEFAULT_CACHE_SIZE / 2 - 1;
+    const int tilesX = (width - 2) / lodTileSize + 1;
+
+    for (size_t t = 0; t < tiles.size(); t++) {
+        int tileX0 = (int)(t % tilesX) * lodTileSize, tileX1 = std::min(width - 1, tileX0 + lodTileSize);
+        int tileZ0 = (int)(t / tilesX) * lodTileSize, tileZ1 = std::min(height - 1, tileZ0 + lodTileSize);
+        tiles[t].fullFirst = (unsigned int)mesh.indices.size();
+
+        for (int x0 = tileX0; x0 < tileX1; x0 += stripCells) {
+            int x1 = std::min(tileX1, x0 + stripCells);
+            for (int z = tileZ0; z < tileZ1; z++) {
+                for (int x = x0; x < x1; x++) {
+                    int a = z * width + x;
+                    int b = z * width + (x + 1);
+                    int c = (z + 1) * width + x;
+                    int d = (z + 1) * width + (x + 1);
+
+                    // First triangle
+                    mesh.indices.push_back(a);
+                    mesh.indices.push_back(c);
+                    mesh.indices.push_back(b);
+
+                    // Second triangle
+                    mesh.indices.push_back(b);
+                    mesh.indices.push_back(c);
+                    mesh.indices.push_back(d);
+                }
+            }
         }
+        tiles[t].fullCount = (unsigned int)mesh.indices.size() - tiles[t].fullFirst;
     }
 }
 
+void Terrain::optimizeLayout() {
+    // Vertices in first-use order so fetches walk memory linearly
+    MeshOptimizer::optimizeVertexFetch(mesh.vertices, mesh.indices);
+}
+
 void Terrain::calculateNormals() {
     // Initialize normals to zero
     for (auto& v : mesh.vertices) {
@@ -95,28 +390,5 @@ void Terrain::calculateNormals() {
 
 Vector3 Terrain::getColorByHeight(float height) {
     // Color gradient based on height
-    float normalized = height / heightScale;
-    normalized = std::max(0.0f, std::min(1.0f, normalized));
-
-    if (normalized < 0.3f) {
-        // Deep: Dark blue to light blue
-        float t = normalized / 0.3f;
-        return Vector3(0.1f + t * 0.2f, 0.2f + t * 0.3f, 0.4f + t * 0.3f);
-    } else if (normalized < 0.45f) {
-        // Sand: Light blue to sand
-        float t = (normalized - 0.3f) / 0.15f;
-        return Vector3(0.3f + t * 0.4f, 0.5f + t * 0.3f, 0.7f - t * 0.3f);
-    } else if (normalized < 0.7f) {
-        // Grass: Sand to green
-        float t = (normalized - 0.45f) / 0.25f;
-        return Vector3(0.7f - t * 0.4f, 0.8f + t * 0.15f, 0.4f - t * 0.2f);
-    } else if (normalized < 0.85f) {
-        // Forest: Green to dark green
-        float t = (normalized - 0.7f) / 0.15f;
-        return Vector3(0.3f - t * 0.1f, 0.95f - t * 0.3f, 0.2f + t * 0.1f);
-    } else {
-        // Snow: Dark to white
-        float t = (normalized - 0.85f) / 0.15f;
-        return Vector3(0.8f + t * 0.2f, 0.8f + t * 0.2f, 0.8f + t * 0.2f);
-    }
+    return colorRamp.sample(height / heightScale);
 }
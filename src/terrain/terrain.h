@@ -1,29 +1,87 @@
 #ifndef TERRAIN_H
 #define TERRAIN_H
 
+#include <atomic>
 #include <vector>
 #include "../graphics/mesh.h"
 #include "perlin_noise.h"
+#include "color_ramp.h"
+#include "ambient_occlusion.h"
 #include "../math/math.h"
+#include "../core/job_system.h"
+#include "../graphics/upload_queue.h"
 
 class Terrain {
 public:
     Mesh mesh;
+    Mesh lodMesh;       // adaptive mesh, used per tile beyond lodDistance
+    float lodMaxError;  // max vertical error of lodMesh in world units
+    float lodDistance;
+    int lodTileSize;    // cells per side of a LOD tile
+
+    // Both meshes keep one index range per tile. Tile edges are full
+    // resolution in both, so full and LOD tiles can be mixed freely.
+    // Jobs fill the ranges (and patchBounds); other threads may read them
+    // only after tilesReady() returns true.
+    struct Tile {
+        float minX, maxX, minZ, maxZ;
+        unsigned int fullFirst = 0, fullCount = 0;
+        unsigned int lodFirst = 0, lodCount = 0;
+    };
+    std::vector<Tile> tiles;
+    bool tilesReady() const { return tilesPublished.load(std::memory_order_acquire); }
     int width, height;
     float scale;
     float heightScale;
+    std::vector<float> heightMap; // width * height samples, row-major
+    int patchSize;                   // cells per side of a bounds patch
+    std::vector<BoundingBox> patchBounds; // world bounds per patch, row-major
+    std::vector<unsigned char> occlusionMap; // baked AO per grid sample, 255 = open sky
+    ColorRamp colorRamp;
+
+    // Color from the ramp texture in the shader instead of per-vertex
+    bool gpuColors;
 
     Terrain(int width = 200, int height = 200, float scale = 1.0f, float heightScale = 50.0f);
 
-    void generate();
+    // Builds and uploads the meshes on the calling (GL) thread; only the
+    // occlusion bake is split across jobs
+    void generate(JobSystem& jobs);
+
+    // Noise heights for grid row z (width values), without touching the mesh
+    void sampleRow(int z, float* heights) const;
+
+    // Runs the generation stages as jobs and pushes the finished mesh to
+    // the upload queue. The terrain must outlive the returned job.
+    JobHandle generateAsync(JobSystem& jobs, UploadQueue& uploads);
+
     void generateWithHeightmap(float minHeight, float maxHeight);
     void calculateNormals();
     Vector3 getColorByHeight(float height);
+
+    // Builds lodMesh from heightMap with at most lodMaxError vertical error.
+    // Left empty when it would not reduce the triangle count.
+    void buildLodMesh();
+
     void draw() const { mesh.draw(); }
 
+    // Draws each tile from lodMesh when it is beyond lodDistance and the
+    // LOD tile has fewer triangles, otherwise from the full mesh
+    void draw(const Vector3& viewPos) const;
+
 private:
     PerlinNoise noiseGenerator;
+    std::atomic<bool> tilesPublished;   // set once all tile ranges are final
+    void prepareBuffers();
+    void sampleHeights(int zBegin, int zEnd);
     void generateIndices();
+    void computePatchBounds();
+    void bakeOcclusion(JobSystem& jobs);
+    void applyOcclusion(Mesh& target) const;
+    void logOcclusion(double milliseconds) const;
+    void optimizeLayout();
+    void logStats() const;
+    Vector3 sampleNormal(float gridX, float gridZ) const;
 };
 
 #endif // TERRAIN_H
@@ -0,0 +1,99 @@
+// Compares the pyramid horizon search with a brute-force march along the
+// same 8 directions, one sample per cell.
+#include "terrain/ambient_occlusion.h"
+#include "math/math.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << std::endl;
+        failures++;
+    }
+}
+
+static std::vector<unsigned char> bruteForce(const std::vector<float>& heights, int width, int height, float cellSize) {
+    const int directions = AmbientOcclusionBaker::DIRECTIONS;
+    std::vector<unsigned char> occlusion((size_t)width * height);
+    for (int z = 0; z < height; z++) {
+        for (int x = 0; x < width; x++) {
+            float h0 = heights[(size_t)z * width + x];
+            float sinSum = 0.0f;
+            for (int d = 0; d < directions; d++) {
+                float angle = 2.0f * PI * d / directions;
+                float dirX = std::cos(angle), dirZ = std::sin(angle);
+                float slope = 0.0f;
+                for (int t = 1;; t++) {
+                    int sx = x + (int)std::lround(dirX * t);
+                    int sz = z + (int)std::lround(dirZ * t);
+                    if (sx < 0 || sx >= width || sz < 0 || sz >= height) break;
+                    float distance = std::sqrt((float)((sx - x) * (sx - x) + (sz - z) * (sz - z))) * cellSize;
+                    slope = std::max(slope, (heights[(size_t)sz * width + sx] - h0) / distance);
+                }
+                sinSum += slope / std::sqrt(1.0f + slope * slope);
+            }
+            occlusion[(size_t)z * width + x] = (unsigned char)((1.0f - sinSum / directions) * 255.0f + 0.5f);
+        }
+    }
+    return occlusion;
+}
+
+static void compare(const char* name, const std::function<float(float, float)>& surface) {
+    const int size = 129;
+    const float cellSize = 1.0f;
+    std::vector<float> heights((size_t)size * size);
+    for (int z = 0; z < size; z++) {
+        for (int x = 0; x < size; x++) {
+            heights[(size_t)z * size + x] = surface(x * cellSize, z * cellSize);
+        }
+    }
+
+    AmbientOcclusionBaker baker;
+    baker.build(heights, size, size, cellSize, cellSize);
+    std::vector<unsigned char> baked = baker.bake();
+    std::vector<unsigned char> reference = bruteForce(heights, size, size, cellSize);
+
+    double meanError = 0.0;
+    int maxError = 0;
+    for (size_t i = 0; i < baked.size(); i++) {
+        int error = (int)baked[i] - (int)reference[i];
+        meanError += error;
+        maxError = std::max(maxError, std::abs(error));
+    }
+    meanError /= baked.size();
+    std::cout << name << ": mean error " << meanError << ", max " << maxError << " (of 255)" << std::endl;
+
+    check(std::fabs(meanError) < 12.0, name);
+    check(maxError < 64, name);
+}
+
+int main() {
+    compare("plane, slope 0.5", [](float x, float) { return 0.5f * x; });
+    compare("gaussian hill", [](float x, float z) {
+        float dx = x - 64.0f, dz = z - 64.0f;
+        return 30.0f * std::exp(-(dx * dx + dz * dz) / (2.0f * 15.0f * 15.0f));
+    });
+    compare("bowl", [](float x, float z) {
+        float dx = x - 64.0f, dz = z - 64.0f;
+        return 0.008f * (dx * dx + dz * dz);
+    });
+
+    // Flat ground is open sky everywhere
+    std::vector<float> flat(64 * 64, 1.0f);
+    AmbientOcclusionBaker baker;
+    baker.build(flat, 64, 64, 1.0f, 1.0f);
+    std::vector<unsigned char> open = baker.bake();
+    check(std::all_of(open.begin(), open.end(), [](unsigned char v) { return v == 255; }), "flat ground is unoccluded");
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All ambient occlusion checks passed" << std::endl;
+    return 0;
+}
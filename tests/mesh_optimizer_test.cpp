@@ -0,0 +1,153 @@
+// Vertex cache and fetch optimizer checks. Needs no GL context: only the
+// Vertex layout comes from mesh.h.
+#include "graphics/mesh_optimizer.h"
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <random>
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << std::endl;
+        failures++;
+    }
+}
+
+// Two triangles per cell, same winding as Terrain::generateIndices()
+static void addCell(std::vector<unsigned int>& indices, int width, int x, int z) {
+    unsigned int a = (unsigned int)(z * width + x);
+    unsigned int b = a + 1;
+    unsigned int c = a + (unsigned int)width;
+    unsigned int d = c + 1;
+    indices.insert(indices.end(), { a, c, b, b, c, d });
+}
+
+static std::vector<unsigned int> rowMajorGrid(int width, int height) {
+    std::vector<unsigned int> indices;
+    for (int z = 0; z < height - 1; z++) {
+        for (int x = 0; x < width - 1; x++) {
+            addCell(indices, width, x, z);
+        }
+    }
+    return indices;
+}
+
+static std::vector<unsigned int> stripGrid(int width, int height) {
+    const int stripCells = MeshOptimizer::DEFAULT_CACHE_SIZE / 2 - 1;
+    std::vector<unsigned int> indices;
+    for (int x0 = 0; x0 < width - 1; x0 += stripCells) {
+        int x1 = std::min(width - 1, x0 + stripCells);
+        for (int z = 0; z < height - 1; z++) {
+            for (int x = x0; x < x1; x++) {
+                addCell(indices, width, x, z);
+            }
+        }
+    }
+    return indices;
+}
+
+// Triangles with their vertices rotated to a canonical start, sorted
+static std::vector<std::array<unsigned int, 3>> triangleSet(const std::vector<unsigned int>& indices) {
+    std::vector<std::array<unsigned int, 3>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        std::array<unsigned int, 3> t = { indices[i], indices[i + 1], indices[i + 2] };
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        triangles.push_back(t);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+static void testStripOrder() {
+    const int width = 4096, height = 64;
+    const size_t vertexCount = (size_t)width * height;
+    float rowMajor = MeshOptimizer::computeACMR(rowMajorGrid(width, height), vertexCount);
+    float strips = MeshOptimizer::computeACMR(stripGrid(width, height), vertexCount);
+    std::cout << "ACMR " << width << "x" << height << ": row-major " << rowMajor << ", strips " << strips << std::endl;
+
+    check(rowMajor > 0.95f, "row-major order over a wide grid misses on nearly every vertex");
+    check(strips < 0.7f, "strip order keeps the previous row in the cache");
+}
+
+static void testTipsify() {
+    const int width = 256, height = 256;
+    const size_t vertexCount = (size_t)width * height;
+
+    // Shuffled triangles are the worst realistic input
+    std::vector<unsigned int> input = rowMajorGrid(width, height);
+    std::vector<std::array<unsigned int, 3>> triangles;
+    for (size_t i = 0; i < input.size(); i += 3) {
+        triangles.push_back({ input[i], input[i + 1], input[i + 2] });
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(12345));
+    std::vector<unsigned int> shuffled;
+    for (const auto& t : triangles) {
+        shuffled.insert(shuffled.end(), t.begin(), t.end());
+    }
+
+    for (const std::vector<unsigned int>* source : { &input, &shuffled }) {
+        std::vector<unsigned int> optimized = *source;
+        MeshOptimizer::optimizeVertexCache(optimized, vertexCount);
+        float before = MeshOptimizer::computeACMR(*source, vertexCount);
+        float after = MeshOptimizer::computeACMR(optimized, vertexCount);
+        std::cout << "Tipsify: " << before << " -> " << after << std::endl;
+
+        check(after < before, "Tipsify lowers the ACMR of its input");
+        check(triangleSet(optimized) == triangleSet(*source), "Tipsify keeps every triangle and its winding");
+    }
+}
+
+static void testVertexFetch() {
+    const int width = 64, height = 64;
+    std::vector<Vertex> vertices((size_t)width * height + 10); // the last 10 are unreferenced
+    for (size_t i = 0; i < vertices.size(); i++) {
+        vertices[i].position = Vector3((float)i, 0.0f, 0.0f);
+    }
+    std::vector<Vertex> original = vertices;
+
+    std::vector<unsigned int> indices = stripGrid(width, height);
+    MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+    std::vector<unsigned int> before = indices;
+    std::vector<unsigned int> remap = MeshOptimizer::optimizeVertexFetch(vertices, indices);
+
+    std::vector<unsigned int> sorted = remap;
+    std::sort(sorted.begin(), sorted.end());
+    bool permutation = remap.size() == original.size();
+    for (size_t i = 0; permutation && i < sorted.size(); i++) {
+        permutation = sorted[i] == i;
+    }
+    check(permutation, "optimizeVertexFetch remap is a permutation");
+    check(vertices.size() == original.size(), "optimizeVertexFetch keeps every vertex");
+
+    bool moved = permutation;
+    for (size_t i = 0; moved && i < original.size(); i++) {
+        moved = vertices[remap[i]].position.x == original[i].position.x;
+    }
+    check(moved, "vertices move to their remapped slot");
+
+    bool rewritten = indices.size() == before.size();
+    unsigned int nextNew = 0;
+    bool firstUse = true;
+    for (size_t i = 0; rewritten && i < indices.size(); i++) {
+        rewritten = indices[i] == remap[before[i]];
+        if (indices[i] == nextNew) nextNew++;
+        else if (indices[i] > nextNew) firstUse = false;
+    }
+    check(rewritten, "indices are rewritten through the remap");
+    check(firstUse, "vertices are in first-use order");
+}
+
+int main() {
+    testStripOrder();
+    testTipsify();
+    testVertexFetch();
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All mesh optimizer checks passed" << std::endl;
+    return 0;
+}
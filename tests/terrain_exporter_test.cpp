@@ -0,0 +1,81 @@
+// Round trip of the tiled (.trn) export: every tile read back with
+// readTile() must match the noise rows within 16-bit quantization.
+#include "export/terrain_exporter.h"
+#include "terrain/terrain.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << std::endl;
+        failures++;
+    }
+}
+
+int main() {
+    // Not a multiple of the tile size, so edge tiles are partial
+    const int width = 300, height = 170, tileSize = 64;
+    const std::string path = "terrain_exporter_test.trn";
+
+    Terrain terrain(width, height, 200.0f, 80.0f);
+    std::vector<float> heights((size_t)width * height);
+    for (int z = 0; z < height; z++) {
+        terrain.sampleRow(z, &heights[(size_t)z * width]);
+    }
+
+    TerrainExporter exporter = TerrainExporter::fromTerrain(terrain);
+    check(exporter.writeTiled(path, tileSize), "writeTiled succeeds");
+
+    const int tilesX = (width - 2) / tileSize + 1;
+    const int tilesZ = (height - 2) / tileSize + 1;
+    int tilesRead = 0;
+    float worstError = 0.0f;
+    bool withinQuantization = true;
+    bool sizesMatch = true;
+
+    for (int tz = 0; tz < tilesZ; tz++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            TerrainExporter::Tile tile;
+            if (!TerrainExporter::readTile(path, tx, tz, tile)) continue;
+            tilesRead++;
+
+            // Tiles share their edge samples with their neighbours
+            int expectedX = std::min(tileSize, width - 1 - tx * tileSize) + 1;
+            int expectedZ = std::min(tileSize, height - 1 - tz * tileSize) + 1;
+            sizesMatch = sizesMatch && tile.samplesX == expectedX && tile.samplesZ == expectedZ;
+            if (tile.samplesX != expectedX || tile.samplesZ != expectedZ) continue;
+
+            float tolerance = (tile.maxHeight - tile.minHeight) / 65535.0f * 0.5f + 1e-4f;
+            for (int r = 0; r < tile.samplesZ; r++) {
+                for (int c = 0; c < tile.samplesX; c++) {
+                    float expected = heights[(size_t)(tz * tileSize + r) * width + tx * tileSize + c];
+                    float error = std::fabs(tile.heights[(size_t)r * tile.samplesX + c] - expected);
+                    worstError = std::max(worstError, error);
+                    withinQuantization = withinQuantization && error <= tolerance;
+                }
+            }
+        }
+    }
+    std::cout << "Read " << tilesRead << " of " << tilesX * tilesZ << " tiles, worst height error "
+              << worstError << std::endl;
+
+    check(tilesRead == tilesX * tilesZ, "every tile reads back");
+    check(sizesMatch, "tile sample counts match the grid");
+    check(withinQuantization, "heights match sampleRow within 16-bit quantization");
+
+    TerrainExporter::Tile outside;
+    check(!TerrainExporter::readTile(path, tilesX, 0, outside), "tiles past the grid are rejected");
+
+    std::remove(path.c_str());
+
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "All terrain exporter checks passed" << std::endl;
+    return 0;
+}